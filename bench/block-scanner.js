@@ -0,0 +1,136 @@
+#!/usr/bin/env node
+
+/**
+ * @file Scaling benchmark for BlockScanner.
+ *
+ * Generates comment-dense LPC sources of doubling size and extracts their
+ * blocks both with BlockScanner and with the rescan-and-splice approach the
+ * bundled parsers used before it. Doubling the input should roughly double
+ * BlockScanner's time (linear), while the legacy approach grows about
+ * fourfold (quadratic).
+ *
+ * Usage:
+ *   node bench/block-scanner.js [--max <blocks>] [--json]
+ */
+
+import console from "node:console"
+import process from "node:process"
+import {parseArgs} from "node:util"
+
+import BlockScanner from "../src/BlockScanner.js"
+
+const {values: args} = parseArgs({
+  options: {
+    max: {type: "string", default: "8000"},
+    json: {type: "boolean", default: false},
+  },
+})
+
+const regexes = new Map([
+  ["block-start", /^\s*\/\*\*.*$/],
+  ["block-stop", /^\s*\*\/\s*$/],
+  ["function", /^\s*(?:public|protected|private)?\s*(?<type>int|void|string|mixed|mapping|object)\s*\*?\s*(?<name>[a-zA-Z_]\w*)\s*\((?<parms>.*)\)\s*\{?.*/],
+])
+
+const scanner = new BlockScanner({
+  open: line => regexes.get("block-start").test(line),
+  close: line => regexes.get("block-stop").test(line),
+  declaration: line => regexes.get("function").exec(line),
+})
+
+/**
+ * The pre-BlockScanner extraction: find the next block, splice it off the
+ * front, find its function, splice again.
+ *
+ * @param {string} source - LPC source
+ * @returns {Array<object>} The blocks
+ */
+function legacy(source) {
+  const result = []
+  const lines = `${source}\n`.split("\n")
+
+  while(lines.length) {
+    const start = lines.findIndex(line => regexes.get("block-start").test(line))
+    const end = lines.findIndex(line => regexes.get("block-stop").test(line))
+
+    if(start < 0 || end <= start)
+      break
+
+    const block = {lines: lines.slice(start + 1, end)}
+
+    lines.splice(0, end + 1)
+
+    const id = lines.findIndex(line => regexes.get("function").test(line))
+    const next = lines.findIndex(line => regexes.get("block-start").test(line))
+
+    if(id > -1) {
+      if(next !== -1 && id > next) {
+        lines.splice(0, next)
+      } else {
+        block.function = regexes.get("function").exec(lines[id])
+        lines.splice(0, id + 1)
+        result.push(block)
+      }
+    }
+  }
+
+  return result
+}
+
+function corpus(blocks) {
+  const out = []
+
+  for(let i = 0; i < blocks; i++) {
+    out.push(
+      "/**",
+      ` * Function number ${i}.`,
+      " *",
+      " * @param {string} arg - The argument",
+      " * @returns {int} - Something",
+      " */",
+      `int fn_${i}(string arg) {`,
+      `  return sizeof(arg) + ${i};`,
+      "}",
+      ""
+    )
+  }
+
+  return out.join("\n")
+}
+
+async function time(fn) {
+  const start = process.hrtime.bigint()
+  const result = await fn()
+  const ms = Number(process.hrtime.bigint() - start) / 1e6
+
+  return {ms, count: result.length}
+}
+
+const max = Number(args.max)
+const rows = []
+
+for(let blocks = 500; blocks <= max; blocks *= 2) {
+  const source = corpus(blocks)
+  const scan = await time(() => scanner.scan(source))
+  const old = await time(() => legacy(source))
+
+  if(scan.count !== old.count)
+    throw new Error(`Block count mismatch at ${blocks}: ${scan.count} vs ${old.count}`)
+
+  rows.push({
+    blocks,
+    bytes: Buffer.byteLength(source),
+    scannerMs: Number(scan.ms.toFixed(2)),
+    legacyMs: Number(old.ms.toFixed(2)),
+  })
+}
+
+if(args.json) {
+  console.log(JSON.stringify(rows, null, 2))
+} else {
+  console.table(rows.map((row, i) => ({
+    ...row,
+    scannerGrowth: i ? (row.scannerMs / rows[i - 1].scannerMs).toFixed(2) : "",
+    legacyGrowth: i ? (row.legacyMs / rows[i - 1].legacyMs).toFixed(2) : "",
+  })))
+}
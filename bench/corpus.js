@@ -0,0 +1,68 @@
+/**
+ * @file Synthetic corpus generator for the BeDoc benchmarks.
+ *
+ * Builds a directory of source files shaped like the examples in
+ * `examples/source/<language>`: each generated file is a copy of one of the
+ * samples (cycled in order), optionally repeated `scale` times to make it
+ * larger, and tagged with a unique trailing comment so no two files hash
+ * alike.
+ */
+
+import fs from "node:fs/promises"
+import path from "node:path"
+import url from "node:url"
+
+const root = url.fileURLToPath(new URL("..", import.meta.url))
+
+/** Per-language sample location and comment syntax. */
+export const languages = Object.freeze({
+  lpc: {samples: "examples/source/lpc", extension: "c", comment: "//"},
+  lua: {samples: "examples/source/lua", extension: "lua", comment: "--"},
+})
+
+/**
+ * Generate a corpus.
+ *
+ * @param {object} args
+ * @param {string} args.language - A key of {@link languages}
+ * @param {number} args.files - How many files to generate
+ * @param {number} [args.scale] - How many times to repeat each sample
+ * @param {string} args.directory - Where to write the files (created)
+ * @returns {Promise<{files: number, bytes: number}>} What was written
+ */
+export async function generateCorpus({language, files, scale = 1, directory}) {
+  const spec = languages[language]
+
+  if(!spec)
+    throw new Error(`Unknown corpus language: ${language}`)
+
+  const sampleDir = path.join(root, spec.samples)
+  const names = (await fs.readdir(sampleDir))
+    .filter(name => name.endsWith(`.${spec.extension}`))
+    .sort()
+
+  const samples = await Promise.all(
+    names.map(name => fs.readFile(path.join(sampleDir, name), "utf8"))
+  )
+
+  // Files without any documented functions make for a poor benchmark.
+  const useful = samples.filter(sample => sample.includes(spec.comment === "//" ? "/**" : "---"))
+
+  await fs.mkdir(directory, {recursive: true})
+
+  let bytes = 0
+
+  for(let i = 0; i < files; i++) {
+    const sample = useful[i % useful.length]
+    const content = `${sample.repeat(scale)}\n${spec.comment} synthetic ${i}\n`
+
+    bytes += Buffer.byteLength(content)
+
+    await fs.writeFile(
+      path.join(directory, `file_${String(i).padStart(6, "0")}.${spec.extension}`),
+      content
+    )
+  }
+
+  return {files, bytes}
+}
@@ -0,0 +1,158 @@
+#!/usr/bin/env node
+
+/**
+ * @file Debug-logging overhead benchmark.
+ *
+ * Builds a mock action directory with many parser and formatter modules and
+ * runs Discovery over it repeatedly with debug logging off, through:
+ *
+ * - `none`  — a logger whose every method is a no-op (the floor);
+ * - `gated` — a Glog behind Logger.gate, as BeDoc uses it;
+ * - `glog`  — a bare Glog at log level 0.
+ *
+ * `gated` should be within noise of `none`. A second, smaller measurement
+ * times a single disabled debug call with a computed argument, eager (bare
+ * Glog) versus wrapped in Logger.lazy (gated).
+ *
+ * Usage:
+ *   node bench/logging.js [--actions 500] [--runs 15] [--calls 1000000] [--json]
+ */
+
+import {Glog} from "@gesslar/toolkit"
+import console from "node:console"
+import fs from "node:fs/promises"
+import path from "node:path"
+import {performance} from "node:perf_hooks"
+import process from "node:process"
+import url from "node:url"
+import {parseArgs} from "node:util"
+
+import Discovery from "../src/Discovery.js"
+import Logger from "../src/Logger.js"
+
+const root = url.fileURLToPath(new URL("..", import.meta.url))
+
+const {values: args} = parseArgs({
+  options: {
+    actions: {type: "string", default: "500"},
+    runs: {type: "string", default: "15"},
+    calls: {type: "string", default: "1000000"},
+    json: {type: "boolean", default: false},
+  },
+})
+
+const noop = () => {}
+const loggers = {
+  none: () => ({debug: noop, info: noop, warn: noop, error: noop}),
+  gated: () => Logger.gate(new Glog().withLogLevel(0), 0),
+  glog: () => new Glog().withLogLevel(0),
+}
+
+// Mock actions import their dependencies, so the corpus lives inside the
+// repository where node_modules can be found.
+const mock = await fs.mkdtemp(path.join(root, "bench", ".logging-"))
+
+try {
+  await buildMock(mock, Number(args.actions))
+
+  const validate = () => true
+  const discover = glog => new Discovery({options: {mock}, glog})
+    .discoverActions({}, validate, {})
+
+  // The first run pays for importing every module; time the rest.
+  await discover(loggers.none())
+
+  const samples = Object.fromEntries(Object.keys(loggers).map(name => [name, []]))
+
+  for(let run = 0; run < Number(args.runs); run++) {
+    for(const [name, make] of Object.entries(loggers)) {
+      const glog = make()
+      const start = performance.now()
+
+      await discover(glog)
+
+      samples[name].push(performance.now() - start)
+    }
+  }
+
+  const discovery = Object.fromEntries(Object.entries(samples)
+    .map(([name, times]) => [name, round(median(times))]))
+
+  const result = {
+    actions: Number(args.actions) * 2,
+    runs: Number(args.runs),
+    discoveryMs: discovery,
+    gatedOverheadPct: round((discovery.gated / discovery.none - 1) * 100),
+    disabledCallNs: callCost(Number(args.calls)),
+  }
+
+  if(args.json) {
+    process.stdout.write(`${JSON.stringify(result, null, 2)}\n`)
+  } else {
+    console.table(discovery)
+    console.table(result.disabledCallNs)
+    console.log(`gated overhead over no-op logger: ${result.gatedOverheadPct}%`)
+  }
+} finally {
+  await fs.rm(mock, {recursive: true, force: true})
+}
+
+/**
+ * Fill a directory with copies of the example mock parser and formatter.
+ *
+ * @param {string} directory - The directory
+ * @param {number} count - Copies of each
+ */
+async function buildMock(directory, count) {
+  const source = path.join(root, "examples/mock")
+
+  for(const name of await fs.readdir(source)) {
+    if(name.endsWith(".yaml"))
+      await fs.copyFile(path.join(source, name), path.join(directory, name))
+  }
+
+  for(const kind of ["parser", "formatter"]) {
+    const [original] = (await fs.readdir(source))
+      .filter(name => name.endsWith(`-${kind}.js`))
+    const text = await fs.readFile(path.join(source, original), "utf8")
+
+    for(let i = 0; i < count; i++)
+      await fs.writeFile(path.join(directory, `bedoc-mock${i}-${kind}.js`), text)
+  }
+}
+
+/**
+ * Nanoseconds per disabled debug call with a computed argument.
+ *
+ * @param {number} calls - How many calls to time
+ * @returns {{eager: number, lazy: number}} The cost of each form
+ */
+function callCost(calls) {
+  const items = Array.from({length: 64}, (_, i) => ({path: `/module/${i}.js`}))
+  const bare = loggers.glog()
+  const gated = loggers.gated()
+
+  const time = fn => {
+    const start = performance.now()
+
+    for(let i = 0; i < calls; i++)
+      fn()
+
+    return round(((performance.now() - start) * 1e6) / calls)
+  }
+
+  return {
+    eager: time(() => bare.debug("Modules %o", 2, items.map(item => item.path))),
+    lazy: time(() => gated.debug("Modules %o", 2, Logger.lazy(() => items.map(item => item.path)))),
+  }
+}
+
+function median(values) {
+  const sorted = values.toSorted((a, b) => a - b)
+
+  return sorted[Math.floor(sorted.length / 2)]
+}
+
+function round(n) {
+  return Math.round(n * 100) / 100
+}
@@ -0,0 +1,244 @@
+#!/usr/bin/env node
+
+/**
+ * @file End-to-end pipeline benchmark.
+ *
+ * Generates synthetic LPC and Lua corpora (see corpus.js), runs each through
+ * `BeDoc.processFiles()` with the example parsers and formatters, and writes
+ * a machine-readable JSON report: per-stage latency summaries (taken from
+ * the `metrics` in the processFiles result), queue wait, throughput (files/s and
+ * MB/s) and peak RSS for every scenario, along with the commit and Node
+ * version, so runs can be compared across commits.
+ *
+ * Every scenario runs in its own child process so that peak RSS is its own.
+ *
+ * Usage:
+ *   npm run bench -- [--files 2000] [--scale 1] [--languages lpc,lua]
+ *                    [--maxConcurrent 10] [--adaptive] [--workers 0] [--cache]
+ *                    [--stages read=10,parse=5,format=5,write=10]
+ *                    [--out bench/results/<commit>.json] [--keep]
+ */
+
+import {Schemer} from "@gesslar/negotiator"
+import {DirectoryObject, FileObject, Glog} from "@gesslar/toolkit"
+import {execFileSync} from "node:child_process"
+import console from "node:console"
+import fs from "node:fs/promises"
+import os from "node:os"
+import path from "node:path"
+import process from "node:process"
+import url from "node:url"
+import {parseArgs} from "node:util"
+
+import {generateCorpus} from "./corpus.js"
+import BeDoc from "../src/BeDoc.js"
+import Environment from "../src/Environment.js"
+import Schema from "../src/Schema.js"
+
+const root = url.fileURLToPath(new URL("..", import.meta.url))
+const self = url.fileURLToPath(import.meta.url)
+
+const {values: args} = parseArgs({
+  options: {
+    files: {type: "string", default: "2000"},
+    scale: {type: "string", default: "1"},
+    languages: {type: "string", default: "lpc,lua"},
+    maxConcurrent: {type: "string", default: "10"},
+    adaptive: {type: "boolean", default: false},
+    stages: {type: "string"},
+    workers: {type: "string", default: "0"},
+    cache: {type: "boolean", default: false},
+    out: {type: "string"},
+    keep: {type: "boolean", default: false},
+    child: {type: "string"},
+    corpus: {type: "string"},
+  },
+})
+
+/** BeDoc options per scenario, on top of input/output. */
+const scenarios = {
+  lpc: {
+    mock: path.join(root, "examples/mock"),
+    language: "lpc",
+    format: "markdown",
+  },
+  lua: {
+    mock: path.join(root, "examples/mock"),
+    parser: path.join(root, "examples/node_modules_test/bedoc-lua-parser/bedoc-lua-parser.js"),
+    format: "markdown",
+  },
+}
+
+if(args.child)
+  await child(args.child, args.corpus)
+else
+  await main()
+
+async function main() {
+  const languages = args.languages.split(",").map(l => l.trim()).filter(Boolean)
+  const scratch = await fs.mkdtemp(path.join(os.tmpdir(), "bedoc-bench-"))
+  const runs = []
+
+  try {
+    for(const language of languages) {
+      const corpus = path.join(scratch, language)
+      const generated = await generateCorpus({
+        language,
+        files: Number(args.files),
+        scale: Number(args.scale),
+        directory: path.join(corpus, "source"),
+      })
+
+      console.error(`[bench] ${language}: ${generated.files} files, ${(generated.bytes / 1e6).toFixed(2)} MB`)
+
+      const childArgs = [
+        self, "--child", language, "--corpus", corpus,
+        "--maxConcurrent", args.maxConcurrent, "--workers", args.workers,
+      ]
+
+      if(args.cache)
+        childArgs.push("--cache")
+
+      if(args.adaptive)
+        childArgs.push("--adaptive")
+
+      if(args.stages)
+        childArgs.push("--stages", args.stages)
+
+      const output = execFileSync(process.execPath, childArgs, {
+        encoding: "utf8",
+        maxBuffer: 64 * 1024 * 1024,
+        stdio: ["ignore", "pipe", "inherit"],
+      })
+
+      runs.push({language, ...generated, ...JSON.parse(output)})
+    }
+  } finally {
+    if(!args.keep)
+      await fs.rm(scratch, {recursive: true, force: true})
+  }
+
+  const commit = git("rev-parse", "HEAD")
+  const report = {
+    commit,
+    dirty: git("status", "--porcelain") !== "",
+    node: process.version,
+    platform: `${process.platform}-${process.arch}`,
+    cpus: os.cpus().length,
+    date: new Date().toISOString(),
+    options: {
+      files: Number(args.files),
+      scale: Number(args.scale),
+      maxConcurrent: Number(args.maxConcurrent),
+      adaptive: args.adaptive,
+      stages: args.stages ?? null,
+      workers: Number(args.workers),
+      cache: args.cache,
+    },
+    runs,
+  }
+
+  const out = args.out ?? path.join(root, "bench/results", `${commit?.slice(0, 12) ?? "unknown"}.json`)
+
+  await fs.mkdir(path.dirname(out), {recursive: true})
+  await fs.writeFile(out, `${JSON.stringify(report, null, 2)}\n`)
+
+  console.table(runs.map(run => ({
+    language: run.language,
+    files: run.files,
+    ms: run.durationMs,
+    "files/s": run.filesPerSecond,
+    "MB/s": run.mbPerSecond,
+    "peak RSS MB": run.peakRssMb,
+    errored: run.errored,
+  })))
+
+  console.error(`[bench] wrote ${out}`)
+}
+
+/**
+ * Run a single scenario and print its measurements as JSON on stdout.
+ *
+ * @param {string} language - The scenario to run
+ * @param {string} corpus - The corpus directory (with `source/` inside)
+ */
+async function child(language, corpus) {
+  const basePath = new DirectoryObject(corpus)
+  const outputDir = path.join(corpus, "output")
+
+  await fs.mkdir(outputDir, {recursive: true})
+
+  const glog = new Glog().withName("BeDoc").noDisplayName()
+  const validateBeDocSchema = await Schemer.fromFile(new FileObject(Schema.local, new DirectoryObject(root)))
+
+  const startupStart = process.hrtime.bigint()
+  const bedoc = await BeDoc.new({
+    options: {
+      ...scenarios[language],
+      basePath,
+      input: ["source/*"],
+      output: outputDir,
+      maxConcurrent: Number(args.maxConcurrent),
+      adaptive: args.adaptive,
+      ...(args.stages ? {stages: args.stages} : {}),
+      workers: Number(args.workers),
+      cache: args.cache,
+      cacheDir: path.join(corpus, ".bedoc-cache"),
+    },
+    source: Environment.NPM,
+    glog,
+    validateBeDocSchema,
+  })
+  const startupMs = ms(process.hrtime.bigint() - startupStart)
+
+  if(!(bedoc instanceof BeDoc))
+    throw new Error(bedoc?.message ?? "BeDoc failed to start")
+
+  const result = await bedoc.processFiles()
+  const durationMs = Number(result.duration)
+
+  const sourceBytes = await dirBytes(path.join(corpus, "source"))
+
+  process.stdout.write(JSON.stringify({
+    startupMs,
+    durationMs,
+    filesPerSecond: round(result.totalFiles / (durationMs / 1000)),
+    mbPerSecond: round((sourceBytes / 1e6) / (durationMs / 1000)),
+    peakRssMb: round(process.resourceUsage().maxRSS / 1024),
+    succeeded: result.succeeded.length,
+    warned: result.warned.length,
+    errored: result.errored.length,
+    cache: result.cache,
+    queueWait: result.metrics.queueWait,
+    stages: result.metrics.stages,
+    concurrency: result.metrics.concurrency,
+    pools: result.metrics.pools,
+  }))
+
+  process.exit(0)
+}
+
+async function dirBytes(directory) {
+  let total = 0
+
+  for(const name of await fs.readdir(directory))
+    total += (await fs.stat(path.join(directory, name))).size
+
+  return total
+}
+
+function git(...argv) {
+  try {
+    return execFileSync("git", argv, {cwd: root, encoding: "utf8", stdio: ["ignore", "pipe", "ignore"]}).trim()
+  } catch {
+    return null
+  }
+}
+
+function ms(ns) {
+  return Number(ns) / 1e6
+}
+
+function round(n) {
+  return Math.round(n * 100) / 100
+}
@@ -0,0 +1,147 @@
+#!/usr/bin/env node
+
+/**
+ * @file CLI cold-start benchmark.
+ *
+ * Times whole `bedoc` invocations, each a fresh process, as a pre-commit hook
+ * makes them:
+ *
+ * - `version` — `bedoc --version`: option parsing only, nothing else loaded;
+ * - `run`     — documenting two small LPC files with the example mock actions.
+ *
+ * Each runs with the compile cache (see src/cli.js):
+ *
+ * - `off`  — disabled (NODE_DISABLE_COMPILE_CACHE), every module compiled;
+ * - `cold` — enabled, but empty every time, so it is written and never read;
+ * - `warm` — enabled and primed by an earlier invocation, as from the second
+ *   invocation on in practice.
+ *
+ * Reports the median and minimum wall time of each, in milliseconds.
+ *
+ * Usage:
+ *   npm run bench:startup -- [--runs 20] [--json]
+ */
+
+import {spawnSync} from "node:child_process"
+import console from "node:console"
+import fs from "node:fs/promises"
+import os from "node:os"
+import path from "node:path"
+import {performance} from "node:perf_hooks"
+import process from "node:process"
+import url from "node:url"
+import {parseArgs} from "node:util"
+
+const root = url.fileURLToPath(new URL("..", import.meta.url))
+const cli = path.join(root, "src/cli.js")
+
+const {values: args} = parseArgs({
+  options: {
+    runs: {type: "string", default: "20"},
+    json: {type: "boolean", default: false},
+  },
+})
+
+const scratch = await fs.mkdtemp(path.join(os.tmpdir(), "bedoc-startup-"))
+
+try {
+  const project = await buildProject(path.join(scratch, "project"))
+  const scenarios = {
+    version: ["--version"],
+    run: [
+      "--mock", path.join(root, "examples/mock"),
+      "--language", "lpc",
+      "--format", "markdown",
+      "--input", "source/*.c",
+      "--output", "output",
+    ],
+  }
+  const warmCache = path.join(scratch, "warm")
+  const caches = {
+    off: () => ({NODE_DISABLE_COMPILE_CACHE: "1"}),
+    cold: run => ({NODE_COMPILE_CACHE: path.join(scratch, `cold-${run}`)}),
+    warm: () => ({NODE_COMPILE_CACHE: warmCache}),
+  }
+
+  // Prime the warm cache with both scenarios.
+  for(const argv of Object.values(scenarios))
+    invoke(argv, project, caches.warm())
+
+  const result = {runs: Number(args.runs), node: process.version, ms: {}}
+
+  for(const [scenario, argv] of Object.entries(scenarios)) {
+    const samples = Object.fromEntries(Object.keys(caches).map(name => [name, []]))
+
+    // Interleave the modes so drift in the machine's load hits them alike.
+    for(let run = 0; run < Number(args.runs); run++) {
+      for(const [name, env] of Object.entries(caches))
+        samples[name].push(invoke(argv, project, env(run)))
+    }
+
+    result.ms[scenario] = Object.fromEntries(Object.entries(samples)
+      .map(([name, times]) => [name, {median: round(median(times)), min: round(Math.min(...times))}]))
+  }
+
+  if(args.json) {
+    process.stdout.write(`${JSON.stringify(result, null, 2)}\n`)
+  } else {
+    for(const [scenario, modes] of Object.entries(result.ms)) {
+      console.log(scenario)
+      console.table(modes)
+    }
+  }
+} finally {
+  await fs.rm(scratch, {recursive: true, force: true})
+}
+
+/**
+ * Set up a project directory for the `run` scenario.
+ *
+ * @param {string} directory - The project directory
+ * @returns {Promise<string>} The directory
+ */
+async function buildProject(directory) {
+  const source = path.join(directory, "source")
+
+  await fs.mkdir(source, {recursive: true})
+  await fs.mkdir(path.join(directory, "output"))
+  await fs.writeFile(path.join(directory, "package.json"), "{}\n")
+
+  for(const name of ["arrays.c", "base64.c"])
+    await fs.copyFile(path.join(root, "examples/source/lpc", name), path.join(source, name))
+
+  return directory
+}
+
+/**
+ * Run the CLI once and time it.
+ *
+ * @param {Array<string>} argv - The CLI's arguments
+ * @param {string} cwd - The project directory
+ * @param {object} env - Extra environment variables
+ * @returns {number} Wall time in milliseconds
+ */
+function invoke(argv, cwd, env) {
+  const start = performance.now()
+  const child = spawnSync(process.execPath, [cli, ...argv], {
+    cwd,
+    env: {...process.env, ...env},
+    encoding: "utf8",
+  })
+  const elapsed = performance.now() - start
+
+  if(child.status !== 0)
+    throw new Error(`bedoc ${argv.join(" ")} exited with ${child.status}: ${child.stderr}`)
+
+  return elapsed
+}
+
+function median(values) {
+  const sorted = values.toSorted((a, b) => a - b)
+
+  return sorted[Math.floor(sorted.length / 2)]
+}
+
+function round(n) {
+  return Math.round(n * 100) / 100
+}
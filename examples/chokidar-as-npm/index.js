@@ -1,5 +1,6 @@
 import console from "node:console"
 import chokidar from "chokidar"
+import {FileObject} from "@gesslar/toolkit"
 import BeDoc, {Environment} from "../../src/core/Core.js"
 
 // Directory to watch
@@ -22,20 +23,32 @@ const watcher = chokidar.watch(watchDirectory, {
 
 console.log(`Watching directory: ${watchDirectory}`)
 
+// Negotiate once and reuse the instance for every change. Discovery, module
+// loading and contract negotiation are paid for on the first event only.
+// A failed setup is not kept, so the next event tries again.
+// (`bedoc --watch` does the same thing without chokidar.)
+let bedocPromise = null
+
+const getBeDoc = () => {
+  bedocPromise ??= BeDoc.new({
+    options: Object.assign({}, bedocOptions, {input: [`${watchDirectory}*.c`]}),
+    source: Environment.NPM
+  }).catch(error => {
+    bedocPromise = null
+
+    throw error
+  })
+
+  return bedocPromise
+}
+
 // Process files on change
 const processFile = async(filePath, event) => {
   console.log(`File ${event}: ${filePath}`)
 
   try {
-    // Initialize BeDoc Core instance
-    const options = Object.assign({},
-      bedocOptions,
-      {input: [filePath]}
-    )
-    const bedoc = await BeDoc.new({
-      options, source: Environment.NPM
-    })
-    const result = await bedoc.processFiles(filePath)
+    const bedoc = await getBeDoc()
+    const result = await bedoc.processFiles([new FileObject(filePath)])
 
     for(const {output} of result.succeeded)
       console.log("[OK] `%s`", output.path)
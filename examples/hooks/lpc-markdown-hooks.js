@@ -6,9 +6,14 @@ export class Parse {
   }
 }
 
+/**
+ * One instance of this class serves every file in a run, several of them at
+ * once, so it must not keep per-file state on `this`: whatever one file needs
+ * to carry from one hook to another travels in that file's context instead.
+ * Here each function is handed its joke in `setup`, and picks it up again in
+ * `before$formatFunction`.
+ */
 export class Format {
-  jokes = []
-
   setup = async ctx => {
     const result = await this.getDadJokes(ctx.length)
     const {status, jokes} = result
@@ -16,11 +21,13 @@ export class Format {
     if(status === "error")
       throw new Error(`Failed to fetch jokes: ${result.error}`)
 
-    this.jokes = jokes.map(joke => joke.joke)
+    ctx.forEach((fn, index) => (fn.joke = jokes[index]?.joke))
   }
 
   before$formatFunction = async ctx => {
-    const joke = this.jokes.pop()
+    const {joke} = ctx
+
+    delete ctx.joke
 
     if(joke && ctx.description)
       ctx.description.push("", joke)
@@ -1,124 +1,97 @@
 import "dotenv/config"
 import process from "node:process"
-import {Glog, Time} from "@gesslar/toolkit"
-import Wikid from "@gesslar/wikid"
+import {setTimeout as sleep} from "node:timers/promises"
+import {Glog} from "@gesslar/toolkit"
 
-export class Format {
-  #BASE_URL
-  #BOT_USERNAME
-  #BOT_PASSWORD
+import MediaWikiUploader from "./mediawiki-uploader.js"
 
-  #glog
+/**
+ * Converts markdown code fences to wikitext while formatting. This runs per
+ * file, so it only does in-memory work; uploading is left to the Run hook
+ * below.
+ */
+export class Format {
+  after$formatFunction = (ctx, result) => {
+    if(!Array.isArray(result?.formatted))
+      return
 
-  constructor() {
-    this.#glog = new Glog()
+    result.formatted = result.formatted.map(section =>
+      section.replace(
+        /```c\n([\s\S]+?)```/g,
+        "<syntaxhighlight lang=\"c\">\n$1</syntaxhighlight>\n",
+      ),
+    )
   }
+}
+
+/**
+ * Uploads the run's output to a MediaWiki site once every file has been
+ * written: one login for the whole batch, then one edit per page, instead of
+ * a login and an upload inside each file's pipeline. Only pages whose output
+ * was created or updated by the run are pushed; unchanged ones are skipped.
+ */
+export class Run {
+  #glog = new Glog()
 
   /**
-   * Setup the current hooks and set some initial values.
-   *
-   * @async
+   * @param {object} result - The run's result
+   * @param {{created: Array<object>, updated: Array<object>}} result.manifest
+   *   The outputs the run created or changed
    */
-  setup = async() => {
-    try {
-      const {BASE_URL,BOT_USERNAME,BOT_PASSWORD} = process.env
-      this.#BASE_URL = BASE_URL
-      this.#BOT_USERNAME = BOT_USERNAME
-      this.#BOT_PASSWORD = BOT_PASSWORD
-    } catch(error) {
-      this.#glog.error(`Error setting up hooks:`, error)
-    }
-  }
+  after$run = async({manifest}) => {
+    const changed = [...manifest.created, ...manifest.updated]
 
-  /**
-     * Processes a module at the end, converting the syntax highlighting from
-     * markdown to wikitext.
-     *
-     * Additionally, uploads the data to a MediaWiki site.
-     *
-     * @async
-     * @param {object} module Options object.
-     * @param {string} module.moduleName The name of the module being processed
-     * @param {string} module.moduleContent The output generated by the formatt
-     * @param {number?} [module.count] The number of times we've done this.
-     * @returns {Promise<string>} The altered text.
-     */
-  after$finalize = async(ctx, current) => {
-    /*
-    const {moduleName,moduleContent} = module
-    const count = module.count ?? 0
-
-    const {#BASE_URL: BASE_URL, #BOT_USERNAME: BOT_USERNAME, #BOT_PASSWORD: BOT_PASSWORD} = this
+    if(changed.length === 0)
+      return
+
+    const {BASE_URL, BOT_USERNAME, BOT_PASSWORD} = process.env
     const bot = new MediaWikiUploader()
-    if(!bot)
-      throw new Error("MediaWiki bot not instantiated.")
+    const login = await bot.login({
+      baseUrl: BASE_URL,
+      botUsername: BOT_USERNAME,
+      botPassword: BOT_PASSWORD,
+    })
+
+    if(login.status === "error")
+      throw login.error
+
+    // An output is named after its input's module, which is the page title.
+    for(const output of changed)
+      await this.#upload(bot, login.token, output.module, `${await output.read()}\n{{sefun}}\n`)
+  }
 
-    const info = (...arg) => this.log.info(...arg)
+  async #upload(bot, token, title, content, attempt = 0) {
+    const edit = await bot.createOrEditPage({token, title, content})
 
-    if(count > 0)
-      info(`Retrying \`${moduleName}\` #${count}...`)
+    if(edit.status === "success") {
+      const {oldrevid} = edit.result
+      const url = `${process.env.BASE_URL}/index.php?title=${encodeURIComponent(title)}`
 
-    const wikitext = moduleContent
-      .replace(
-        /```c\n([\s\S]+?)```/g,
-        '<syntaxhighlight lang="c">\n$1</syntaxhighlight>\n',
-      ) + "\n{{sefun}}\n"
+      if(oldrevid === undefined)
+        this.#glog.info(`No change was made to page '${url}'`)
+      else
+        this.#glog.info(`Page ${oldrevid === 0 ? "created" : "edited"} successfully: '${url}'`)
+
+      return
+    }
+
+    let code, info
 
     try {
-      const loginResult = await bot.login({
-        baseUrl: BASE_URL,
-        botUsername: BOT_USERNAME,
-        botPassword: BOT_PASSWORD
-      })
-
-      if(loginResult.status === "error")
-        throw loginResult.error
-
-      const request = {
-        token: loginResult.token,
-        title: moduleName,
-        content: wikitext
-      }
-
-      const editResult = await bot.createOrEditPage(request)
-
-      if(editResult.status === "error") {
-        const data = JSON.parse(editResult.error.message)
-        const secs = 10 + (count * 2)
-
-        if(data?.error?.code) {
-          if(data.error.code === "ratelimited") {
-            this.log.warn(`Rate limited for \`${moduleName}\`. Trying again in ${secs} seconds.`)
-
-            await timeoutPromise(secs*1_000)
-            module.count = count+1
-
-            return this.end(module)
-          } else {
-            throw new Error(`Error uploading \`${moduleName}\`: ${data.error.info}`)
-          }
-        }
-      }
-
-      // console.log(editResult)
-      // console.log(editResult.result)
-      const {title, oldrevid} = editResult.result
-      const sanitizedUrl =
-        `${BASE_URL}/index.php?title=${encodeURIComponent(title)}`
-      if(oldrevid !== undefined) {
-        if(oldrevid === 0) {
-          this.log.info(`Page created successfully: '${sanitizedUrl}'`)
-        } else {
-          this.log.info(`Page edited successfully: '${sanitizedUrl}'`)
-        }
-      } else {
-        this.log.info(`No change was made to page '${sanitizedUrl}'`)
-      }
-    } catch(error) {
-      this.log.error(`Error creating/editing page: ${error.message}`)
+      ({code, info} = JSON.parse(edit.error.message)?.error ?? {})
+    } catch {
+      // Not an API error; reported below.
+    }
+
+    if(code === "ratelimited" && attempt < 5) {
+      const secs = 10 + (attempt * 2)
+
+      this.#glog.warn(`Rate limited for \`${title}\`. Trying again in ${secs} seconds.`)
+      await sleep(secs * 1_000)
+
+      return this.#upload(bot, token, title, content, attempt + 1)
     }
 
-    return wikitext
-    */
+    this.#glog.error(`Error uploading \`${title}\`: ${info ?? edit.error.message}`)
   }
 }
@@ -15,7 +15,10 @@
  */
 
 import {ActionBuilder, ACTIVITY} from "@gesslar/actioneer"
-import {Collection, Data, Util} from "@gesslar/toolkit"
+import {Collection, Util} from "@gesslar/toolkit"
+// These fixture packages have no @gesslar/bedoc of their own to resolve;
+// a published parser imports this as "@gesslar/bedoc/BlockScanner.js".
+import BlockScanner from "../../../src/BlockScanner.js"
 
 const {WHILE} = ACTIVITY
 
@@ -78,60 +81,14 @@ export default class LpcParser {
     )
     .done(this.#finally)
 
-  async #extractBlocks(ctx) {
-    ctx = Data.append(ctx, "\n")
-
-    const result = []
-    const lines = ctx.split("\n")
-
-    while(lines.length) {
-      const block = {}
-
-      // Find the block start index
-      const startIndex = lines.findIndex(line => this.#regexes.get("block-start").exec(line))
-      // Find the block end index
-      const endIndex = lines.findIndex(line => this.#regexes.get("block-stop").exec(line))
-
-      // Hmmmmm! I guess we done here?
-      if(startIndex < 0 || endIndex <= startIndex)
-        break
-
-      // The block is the stuff in between the start and the end
-      block.lines = lines.slice(startIndex+1, endIndex)
-
-      // Ok, yeet out the stuff we don't need anymore; the block's size + the
-      // begin and end. I added +1 cos I don't know how math works, I guess,
-      // but now it is properly gobbling up the */
-      lines.splice(0, endIndex+1)
-
-      // Find the function
-      const idIndex = lines.findIndex(line => this.#regexes.get("function").test(line))
-      // Find the next block
-      const nextBlockIndex = lines.findIndex(line => this.#regexes.get("block-start").test(line))
-
-      if(idIndex > -1) {
-        // they can't be equal, they're different patterns
-        if(nextBlockIndex !== -1 && idIndex > nextBlockIndex) {
-          // but if the found function ID is later than the next block ID,
-          // that means we don't have one for this block. EJECT! EJECT! EJECT!
-          lines.splice(0, nextBlockIndex)
-        } else {
-          // Whew! Safe.
-
-          // Set the function match as a property on the array for later
-          // somethingspection.
-          const func = this.#regexes.get("function").exec(lines[idIndex])
-          block.function = func
-
-          // Slurp! Slurp!
-          lines.splice(0, idIndex + 1)
-
-          result.push(block)
-        }
-      }
-    }
+  #scanner = new BlockScanner({
+    open: line => this.#regexes.get("block-start").test(line),
+    close: line => this.#regexes.get("block-stop").test(line),
+    declaration: line => this.#regexes.get("function").exec(line),
+  })
 
-    return result
+  async #extractBlocks(ctx) {
+    return await this.#scanner.scan(ctx)
   }
 
   // Gimme k/v object that only has k where v isn't null or undefined.
@@ -15,6 +15,9 @@
 
 import {ActionBuilder, ACTIVITY} from "@gesslar/actioneer"
 import {Collection} from "@gesslar/toolkit"
+// These fixture packages have no @gesslar/bedoc of their own to resolve;
+// a published parser imports this as "@gesslar/bedoc/BlockScanner.js".
+import BlockScanner from "../../../src/BlockScanner.js"
 
 /**
  * Lua Parser Class - Parses Lua files to extract function documentation.
@@ -34,11 +37,15 @@ export default class LuaParser {
    * @property {string} kind - The type of action.
    * @property {string} input - The input file type this parser handles.
    * @property {string} terms - The contract file name.
+   * @property {boolean} stream - Takes the source as an async iterable of
+   *   lines (see SourceReader.lines) rather than as one string; the
+   *   BlockScanner reads either.
    */
   static meta = Object.freeze({
     kind: "parser",
     input: "lua",
-    terms: "ref://./bedoc-lua-parser.yaml"
+    terms: "ref://./bedoc-lua-parser.yaml",
+    stream: true
   })
 
   /**
@@ -72,52 +79,12 @@ export default class LuaParser {
     )
     .done(this.#finally)
 
-  #extractBlocks = ctx => {
-    const result = []
-    const lines = ctx.split(/\r?\n/)
-
-    while(lines.length) {
-      const block = {}
-
-      // Find the start of a comment block
-      const startIndex = lines.findIndex(line =>
-        this.#regexes.get("comment-start").test(line.trim())
-      )
-      if(startIndex < 0)
-        break
-
-      // Remove everything before the comment block
-      lines.splice(0, startIndex)
-
-      // Collect all consecutive comment lines
-      const commentLines = []
-      while(lines.length && this.#regexes.get("comment-start").test(lines[0].trim())) {
-        commentLines.push(lines.shift())
-      }
-
-      block.lines = commentLines
-
-      // Look ahead for a function definition, stopping at the next comment start
-      const funcIndex = lines.findIndex(line => {
-        const trimmed = line.trim()
-
-        return this.#regexes.get("function").test(trimmed) ||
-               this.#regexes.get("comment-start").test(trimmed)
-      })
-
-      if(funcIndex >= 0 && this.#regexes.get("function").test(lines[funcIndex].trim())) {
-        block.function = this.#regexes.get("function").exec(lines[funcIndex].trim())
-        lines.splice(0, funcIndex + 1)
-        result.push(block)
-      } else if(funcIndex >= 0) {
-        // Hit another comment start before a function — discard this block
-        lines.splice(0, funcIndex)
-      }
-      // else: no more lines, block has no function — discard
-    }
+  #scanner = new BlockScanner({
+    open: line => this.#regexes.get("comment-start").test(line.trim()),
+    declaration: line => this.#regexes.get("function").exec(line.trim()),
+  })
 
-    return result
-  }
+  #extractBlocks = async ctx => await this.#scanner.scan(ctx)
 
   #extractSignature = ctx => {
     const {function: func} = ctx
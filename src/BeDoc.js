@@ -1,13 +1,19 @@
-import {Contract} from "@gesslar/negotiator"
 import {Data, Sass, Tantrum} from "@gesslar/toolkit"
+import fs from "node:fs/promises"
 import {hrtime} from "node:process"
 
+import BuildCache from "./BuildCache.js"
 import Configuration from "./Configuration.js"
+import ContractCache from "./ContractCache.js"
 import Conveyor from "./Conveyor.js"
 import Discovery from "./Discovery.js"
+import Logger from "./Logger.js"
+import OutputManifest from "./OutputManifest.js"
+import RunReport from "./RunReport.js"
 
 /**
  * @import {DirectoryObject, FileObject, Glog} from "@gesslar/toolkit"
+ * @import {InputSource} from "./InputSource.js"
  */
 
 export default class BeDoc {
@@ -16,12 +22,23 @@ export default class BeDoc {
   #actionDefs
   #validCrit
   #validSchemas
-  #contract
-  #actions
   #validateBeDocSchema
   #hooks
   #basePath
   #cli
+  #modules = {}
+  #cache
+  #report
+
+  /**
+   * One entry per parser: the input globs it is routed (null for the
+   * fallback route), the parser action and its module path, and its
+   * targets — per output format, the formatter action, its contract with
+   * the parser, its module path and its output directory.
+   *
+   * @type {Array<{input: Array<string>|null, parser: object, module: string, targets: Array<object>}>}
+   */
+  #routes = []
 
   constructor({basePath, glog, cliOutput}) {
     this.#glog = glog
@@ -97,18 +114,21 @@ export default class BeDoc {
    * @param {Function} validateBeDocSchema - The action schema validator
    */
   #configure({config, glog, validateBeDocSchema}) {
-    this.#glog = glog
-    this.#validateBeDocSchema = validateBeDocSchema
+    const debugLevel = config.debug && config.debugLevel > 0
+      ? config.debugLevel
+      : 0
+
+    glog.withLogLevel(debugLevel)
 
-    if(config.debug && config.debugLevel > 0)
-      glog.withLogLevel(config.debugLevel)
-    else
-      glog.withLogLevel(0)
+    // Everything downstream (Discovery included) logs through the gate, so
+    // disabled debug messages cost one comparison.
+    this.#glog = Logger.gate(glog, debugLevel)
+    this.#validateBeDocSchema = validateBeDocSchema
 
     if(config.status === "error")
       throw Tantrum.new("BeDoc configuration failed", config.errors)
 
-    glog.debug("Creating new BeDoc instance with options: `%o`", 4, config)
+    this.#glog.debug("Creating new BeDoc instance with options: `%o`", 4, config)
 
     this.#options = config
   }
@@ -123,40 +143,110 @@ export default class BeDoc {
     const options = this.#options
 
     const discovery = new Discovery({options, glog})
+    const routes = this.#routeSpecs()
+    const targets = this.#targetSpecs()
 
+    // A route or target naming no module (null) leaves discovery on for
+    // that kind of action, for its language or format only.
     this.#actionDefs = await discovery.discoverActions({
-      parser: options.parser,
-      formatter: options.formatter,
-    }, this.#validateBeDocSchema)
+      parser: routes.map(route => route.parser ?? null),
+      formatter: targets.map(target => target.formatter ?? null),
+    }, this.#validateBeDocSchema, {
+      parser: routes.filter(route => !route.parser).map(route => route.language ?? null),
+      formatter: targets.filter(target => !target.formatter).map(target => target.format ?? null),
+    })
 
-    this.#validCrit = discovery.satisfyCriteria(this.#actionDefs, options)
+    // Each route is matched against each target on its own.
+    this.#validCrit = routes.map(({language, parser}) =>
+      targets.map(({format, formatter}) =>
+        discovery.satisfyCriteria(this.#actionDefs, {...options, language, parser, format, formatter})))
 
     glog.debug("Actions that met criteria %o", 4, this.#validCrit)
 
-    return !Object.values(this.#validCrit).some(arr => arr.length === 0)
+    return !this.#validCrit.flat().some(crit => Object.values(crit).some(arr => arr.length === 0))
   }
 
   /**
-   * Negotiate contracts between discovered parsers and formatters.
+   * The configured routes. Without the `routes` option there is one,
+   * described by the top-level `language`/`parser`, which otherwise serves
+   * as the fallback for files no route matches.
+   *
+   * @returns {Array<{input: Array<string>|null, language?: string, parser?: FileObject}>}
+   *   The routes
+   */
+  #routeSpecs() {
+    const {routes = [], language, parser} = this.#options
+
+    return routes.length === 0 || language || parser
+      ? [...routes, {input: null, language, parser}]
+      : routes
+  }
+
+  /**
+   * The configured targets. Without the `targets` option there is one,
+   * described by the top-level `format`/`formatter`/`output`.
+   *
+   * @returns {Array<{format?: string, formatter?: FileObject, output?: DirectoryObject}>}
+   *   The targets
+   */
+  #targetSpecs() {
+    const {targets, format, formatter, output} = this.#options
+
+    return targets ?? [{format, formatter, output}]
+  }
+
+  /**
+   * Negotiate contracts between discovered parsers and formatters, for each
+   * route and target.
    *
    * @returns {Promise<BeDoc>} This object for chaining.
    */
   async #negotiate() {
+    const contracts = new ContractCache()
+
+    const validSchemas = []
+
+    for(const route of this.#validCrit) {
+      const negotiated = []
+
+      for(const crit of route)
+        negotiated.push(await this.#negotiateTarget(crit, contracts))
+
+      validSchemas.push(negotiated)
+    }
+
+    this.#validSchemas = validSchemas
+
+    return this
+  }
+
+  /**
+   * Negotiate the parsers of one target's criteria against its formatters.
+   *
+   * @param {{parser: Array<object>, formatter: Array<object>}} crit - The
+   *   actions that met the target's criteria
+   * @param {ContractCache} contracts - The contract cache
+   * @returns {Promise<{parser: Array<object>, formatter: Array<object>}>}
+   *   The compatible actions, each parser carrying its contract
+   */
+  async #negotiateTarget(crit, contracts) {
     const glog = this.#glog
     const validSchemas = {parser: [], formatter: []}
 
-    let formatters = this.#validCrit.formatter.length
+    let formatters = crit.formatter.length
 
     while(formatters--) {
-      const formatter = this.#validCrit.formatter[formatters]
+      const formatter = crit.formatter[formatters]
       const {terms: consumes} = formatter
       const satisfied = []
 
-      for(const parser of this.#validCrit.parser) {
+      for(const parser of crit.parser) {
+        const key = await contracts.key(parser, formatter)
+
         try {
           const {terms: provides} = parser
 
-          const contract = await Contract.negotiate(provides, consumes)
+          const contract = await contracts.negotiate(key, provides, consumes)
 
           satisfied.push({...parser, contract})
         } catch(err) {
@@ -175,48 +265,71 @@ export default class BeDoc {
       }
     }
 
-    this.#validSchemas = validSchemas
-
-    return this
+    return validSchemas
   }
 
   /**
-   * Validate that exactly one action per type was negotiated, then
-   * instantiate the action classes.
+   * Validate that exactly one action per type was negotiated for each route
+   * and target, and that a route's targets share its one parser, then
+   * assign the action classes.
    *
    * @returns {BeDoc} This object for chaining.
    */
   #validateActions() {
     const glog = this.#glog
+    const routeSpecs = this.#routeSpecs()
+    const targetSpecs = this.#targetSpecs()
 
-    const schemas = {}
+    const where = (route, target) => {
+      const parts = [
+        routeSpecs.length > 1 && `route ${route + 1}`,
+        target !== undefined && targetSpecs.length > 1 && `target ${target + 1}`,
+      ].filter(Boolean)
 
-    for(const [key, value] of Object.entries(this.#validSchemas)) {
-      if(value.length === 0)
-        throw Sass.new(`No matching '${key}' action found`)
+      return parts.length ? ` for ${parts.join(", ")}` : ""
+    }
 
-      if(value.length > 1)
-        throw Sass.new(`Multiple matching '${key}' actions found`)
+    this.#routes = this.#validSchemas.map((route, r) => {
+      const negotiated = route.map((validSchemas, t) => {
+        const schemas = {}
 
-      schemas[key] = value[0]
-    }
+        for(const [key, value] of Object.entries(validSchemas)) {
+          if(value.length === 0)
+            throw Sass.new(`No matching '${key}' action found${where(r, t)}`)
 
-    this.#validSchemas = schemas
-    this.#contract = schemas.parser.contract
+          if(value.length > 1)
+            throw Sass.new(`Multiple matching '${key}' actions found${where(r, t)}`)
 
-    glog.debug("Contracts satisfied between parser and formatter", 2)
+          schemas[key] = value[0]
+        }
 
-    const actions = {}
+        return schemas
+      })
 
-    for(const [, {action}] of Object.entries(this.#validSchemas)) {
-      const {kind} = action.default.meta
+      const [{parser}] = negotiated
 
-      glog.debug("Assigning %o action", 2, kind)
+      if(negotiated.some(schemas => schemas.parser.file.path !== parser.file.path))
+        throw Sass.new(`Targets must share a single parser${where(r)}`)
 
-      actions[kind] = action.default
-    }
+      return {
+        input: routeSpecs[r].input,
+        parser: parser.action.default,
+        module: parser.file.path,
+        targets: negotiated.map(({parser, formatter}, t) => ({
+          formatter: formatter.action.default,
+          contract: parser.contract,
+          module: formatter.file.path,
+          output: targetSpecs[t].output,
+        })),
+      }
+    })
+
+    glog.debug("Contracts satisfied for %o route(s) and %o target(s)", 2,
+      this.#routes.length, targetSpecs.length)
 
-    this.#actions = actions
+    this.#modules.parsers = [...new Set(this.#routes.map(route => route.module))]
+    this.#modules.formatters = [...new Set(this.#routes.flatMap(route =>
+      route.targets.map(target => target.module)))]
 
     return this
   }
@@ -251,6 +364,9 @@ export default class BeDoc {
     if(loaded.Format && Data.isType(loaded.Format, "Function"))
       hooks.Format = loaded.Format
 
+    if(loaded.Run && Data.isType(loaded.Run, "Function"))
+      hooks.Run = loaded.Run
+
     if(Data.isEmpty(hooks)) {
       glog.warn(`No hooks found in ${hooksFile.path}`)
 
@@ -258,29 +374,69 @@ export default class BeDoc {
     }
 
     this.#hooks = hooks
+    this.#modules.hooks = hooksFile.path
 
     return this
   }
 
-  async processFiles() {
+  /**
+   * Run the given files (by default, every configured input) through the
+   * Conveyor. May be called repeatedly on the same instance, e.g. by
+   * {@link Watcher}, without repeating discovery or negotiation. With the
+   * `report` option set, each run is also written to a {@link RunReport}.
+   * The result's `manifest` says which outputs were created, updated or left
+   * unchanged, and, after a run over every configured input, which are
+   * orphaned (see {@link OutputManifest}); with the `manifest` option set,
+   * it is also written to that file.
+   * When the hooks module exports a `Run` class, its `after$run` is then
+   * given the result, once for the whole run (see {@link Hooks}).
+   *
+   * @param {Array<FileObject>} [files] - The files to process
+   * @returns {Promise<object>} The categorised results, run duration and
+   *   per-stage timing metrics
+   */
+  async processFiles(files) {
     const glog = this.#glog
 
     glog.debug("Starting file processing with conveyor", 1)
 
-    const {input, output, maxConcurrent} = this.#options
+    const {maxConcurrent, workers, adaptive, stages, hookTimeout, encoding, skipUnchanged} = this.#options
+    // Without a list of files, the configured InputSource is enumerated as
+    // the Conveyor goes.
+    const input = files ?? this.#options.input
 
-    if(!input?.length)
+    if(!input || input.length === 0)
       throw Sass.new("No input files specified")
 
+    if(this.#options.report && !this.#report)
+      this.#report = new RunReport({
+        destination: this.#options.report,
+        basePath: this.#basePath,
+        shard: this.#options.shard,
+      })
+
+    if(this.#options.cache && !this.#cache)
+      this.#cache = await BuildCache.new({
+        directory: this.#options.cacheDir,
+        routes: this.#routes,
+        hooks: this.#modules.hooks,
+        encoding,
+      })
+
     const conveyor = new Conveyor({
-      parser: this.#actions.parser,
-      formatter: this.#actions.formatter,
-      contract: this.#contract,
+      routes: this.#routes,
       hooks: this.#hooks,
+      hookTimeout,
       glog,
-      output,
       basePath: this.#basePath,
-      cli: this.#cli
+      cli: this.#cli,
+      workers,
+      modules: this.#modules,
+      cache: this.#cache,
+      adaptive,
+      stages,
+      encoding,
+      skipUnchanged,
     })
 
     const processStart = hrtime.bigint()
@@ -289,16 +445,152 @@ export default class BeDoc {
 
     glog.debug("Conveyor complete", 1)
 
+    // One shard may come up empty when there are more shards than files.
+    if(processResult.totalFiles === 0 && !(input.shard && await this.#anyInput(input)))
+      throw Sass.new("No input files matched")
+
     const result = {
-      totalFiles: input.length,
+      totalFiles: processResult.totalFiles,
       succeeded: processResult.succeeded,
       warned: processResult.warned,
       errored: processResult.errored,
       duration: ((Number(processEnd - processStart)) / 1_000_000).toFixed(2),
+      metrics: processResult.metrics,
     }
 
+    if(processResult.cache)
+      result.cache = processResult.cache
+
+    // Orphans can only be told apart when every input has been seen; in a
+    // sharded run, the other shards' inputs still own their outputs.
+    if(!files) {
+      if(input.shard)
+        await this.#expectOtherShards(processResult.manifest, input)
+
+      await processResult.manifest.findOrphans(this.#routes.flatMap(route => route.targets))
+
+      // Likewise the build cache; the other shards' entries are not stale.
+      if(!input.shard)
+        await this.#cache?.prune()
+    }
+
+    result.manifest = processResult.manifest.summary()
+
+    if(this.#options.manifest)
+      await OutputManifest.save(result.manifest, {
+        destination: this.#options.manifest,
+        basePath: this.#basePath,
+        shard: this.#options.shard,
+      })
+
+    await this.#report?.end(result)
+
+    await this.#afterRun(result)
+
     glog.debug("File processing complete", 1)
 
     return result
   }
+
+  /**
+   * Whether a sharded input set has any files at all, in any shard.
+   *
+   * @param {InputSource} input - The sharded input
+   * @returns {Promise<boolean>} True if some shard has files
+   */
+  async #anyInput(input) {
+    return (await input.partition()).some(shard => shard.length > 0)
+  }
+
+  /**
+   * Tell a manifest about the outputs of the files in the other shards, so
+   * they are not taken for orphans.
+   *
+   * @param {OutputManifest} manifest - This run's manifest
+   * @param {InputSource} input - The sharded input
+   */
+  async #expectOtherShards(manifest, input) {
+    const shards = await input.partition()
+
+    shards.forEach((files, index) => {
+      if(index === input.shard.index - 1)
+        return
+
+      for(const file of files) {
+        const route = Conveyor.routeFor(file, this.#routes, this.#basePath)
+
+        if(route)
+          manifest.expect(Conveyor.outputsFor(file, route))
+      }
+    })
+  }
+
+  /**
+   * Release what the instance holds between runs: the run report stops
+   * listening for conveyor events. Call once done with the instance.
+   */
+  close() {
+    this.#report?.dispose()
+    this.#report = null
+  }
+
+  /**
+   * Give a finished run's result to the `Run` hook, if there is one. A
+   * failure there is logged rather than thrown: the run's outputs are
+   * already written.
+   *
+   * @param {object} result - The processFiles result
+   */
+  async #afterRun(result) {
+    if(!this.#hooks?.Run)
+      return
+
+    const hook = new this.#hooks.Run()
+
+    if(!Data.isType(hook.after$run, "Function"))
+      return
+
+    try {
+      this.#glog.debug("Running after$run hook", 1)
+
+      await hook.after$run(result)
+    } catch(error) {
+      this.#glog.error(`after$run hook failed: ${error?.message ?? error}`)
+    }
+  }
+
+  /**
+   * Remove the outputs previously generated for input files that no longer
+   * exist, and their build cache entries.
+   *
+   * @param {Array<FileObject>} files - The vanished input files
+   * @returns {Promise<Array<FileObject>>} The outputs that were removed
+   */
+  async removeOutputs(files) {
+    const removed = []
+
+    for(const file of files) {
+      const route = Conveyor.routeFor(file, this.#routes, this.#basePath)
+
+      await this.#cache?.forget(file)
+
+      for(const {formatter, output} of route?.targets ?? []) {
+        if(!output)
+          continue
+
+        const target = Conveyor.outputFor(file, formatter, output)
+
+        if(!await target.exists)
+          continue
+
+        await fs.rm(target.path, {force: true})
+
+        removed.push(target)
+      }
+    }
+
+    await this.#cache?.save()
+
+    return removed
+  }
 }
@@ -0,0 +1,168 @@
+/**
+ * Single-pass extractor of documentation comment blocks and the declaration
+ * that follows each one, for parsers to build on.
+ *
+ * The scanner makes one linear sweep over the source, never rescanning or
+ * splicing what is left of it, so it scales with the size of the input
+ * rather than with blocks × lines. It accepts the whole source as a string
+ * or, for parsers using the streaming input protocol, any (async) iterable
+ * of lines; only the lines of the block currently being collected are held.
+ *
+ * Two block shapes are supported:
+ * - delimited — `open` starts a block and `close` ends it; neither line is
+ *   part of the block (e.g. `/** … *\/`)
+ * - run — without `close`, a block is a run of consecutive lines matching
+ *   `open`, all of which are part of it (e.g. Lua `---` comments)
+ *
+ * After a block, the first line matching `declaration` is attached to it.
+ * A block that reaches another block's opening line (or the end of input)
+ * before finding a declaration is dropped.
+ *
+ * @example
+ * // Lua: a run of `---` lines documenting the next `function`.
+ * const scanner = new BlockScanner({
+ *   open: line => line.trim().startsWith("---"),
+ *   declaration: line => /^\s*function\s+(?<name>[\w.:]+)/.exec(line),
+ * })
+ *
+ * const blocks = await scanner.scan(source)
+ * // [{lines: [...], function: RegExpExecArray, start: 0, end: 4, line: 5}]
+ */
+export default class BlockScanner {
+  #open
+  #close
+  #declaration
+
+  /**
+   * Constructor for BlockScanner.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {(line: string) => boolean} arg.open - Whether a line opens a block
+   * @param {(line: string) => boolean} [arg.close] - Whether a line closes a
+   *   delimited block. Omit for run blocks.
+   * @param {(line: string) => (RegExpExecArray|null)} arg.declaration - Match
+   *   the declaration a block documents
+   */
+  constructor({open, close, declaration}) {
+    this.#open = open
+    this.#close = close ?? null
+    this.#declaration = declaration
+  }
+
+  /**
+   * Split a string into lines lazily, without materialising an array of
+   * them. `\r\n` endings are handled.
+   *
+   * @param {string} source - The source text
+   * @yields {string} Each line, without its terminator
+   */
+  static *lines(source) {
+    let from = 0
+
+    while(from <= source.length) {
+      let to = source.indexOf("\n", from)
+
+      if(to < 0)
+        to = source.length
+
+      const line = source.charCodeAt(to - 1) === 13
+        ? source.slice(from, to - 1)
+        : source.slice(from, to)
+
+      yield line
+
+      from = to + 1
+    }
+  }
+
+  /**
+   * Scan a source for documented declarations.
+   *
+   * @param {string|Iterable<string>|AsyncIterable<string>} source - The
+   *   source text, or its lines
+   * @returns {Promise<Array<object>>} The blocks found, in order. Each has
+   *   `lines` (the comment lines), `function` (the declaration match),
+   *   `start`/`end` (zero-based line numbers of the comment's first and
+   *   last lines) and `line` (the declaration's line number).
+   */
+  async scan(source) {
+    const blocks = []
+    const state = {mode: "idle", block: null}
+    let index = 0
+
+    // Stay synchronous when we can; awaiting every line of a string would
+    // cost a microtask per line for nothing.
+    if(typeof source === "string" || typeof source[Symbol.asyncIterator] !== "function") {
+      const input = typeof source === "string"
+        ? BlockScanner.lines(source)
+        : source
+
+      for(const line of input)
+        this.#step(state, line, index++, blocks)
+    } else {
+      for await(const line of source)
+        this.#step(state, line, index++, blocks)
+    }
+
+    return blocks
+  }
+
+  #step(state, line, index, blocks) {
+    switch(state.mode) {
+      case "delimited":
+        if(this.#close(line)) {
+          state.block.end = index - 1
+          state.mode = "after"
+        } else {
+          state.block.lines.push(line)
+        }
+
+        return
+
+      case "run":
+        if(this.#open(line)) {
+          state.block.lines.push(line)
+          state.block.end = index
+
+          return
+        }
+
+        state.mode = "after"
+        break // this line may already be the declaration
+
+      case "after":
+        break
+
+      default: // idle
+        this.#begin(state, line, index)
+
+        return
+    }
+
+    // Looking for the declaration that belongs to the current block.
+    const match = this.#declaration(line)
+
+    if(match) {
+      blocks.push(Object.assign(state.block, {function: match, line: index}))
+
+      state.mode = "idle"
+      state.block = null
+    } else if(this.#open(line)) {
+      // Another block started first; this one documented nothing.
+      this.#begin(state, line, index)
+    }
+  }
+
+  #begin(state, line, index) {
+    if(!this.#open(line))
+      return
+
+    if(this.#close) {
+      state.mode = "delimited"
+      state.block = {lines: [], start: index + 1, end: index}
+    } else {
+      state.mode = "run"
+      state.block = {lines: [line], start: index, end: index}
+    }
+  }
+}
@@ -0,0 +1,435 @@
+import {Data, DirectoryObject, FileObject} from "@gesslar/toolkit"
+import {createHash} from "node:crypto"
+import {createReadStream} from "node:fs"
+import {rm} from "node:fs/promises"
+import path from "node:path"
+import url from "node:url"
+
+/**
+ * Bump when the shape of anything written to the cache changes, so stale
+ * caches from older BeDoc versions are discarded instead of misread.
+ */
+const CACHE_VERSION = 2
+
+/**
+ * Persistent, content-hash keyed incremental build cache for {@link Conveyor}.
+ *
+ * Every input file is recorded with three keys:
+ * - `content` — hash of the file's contents
+ * - `parse` — identity of its route's parser, its terms and the hooks module
+ * - `format` — the parse key plus each of the route's formatters and terms
+ *
+ * A module's identity is its source and that of every local module it
+ * imports, transitively (see {@link BuildCache.moduleSource}), plus the
+ * name and version of the package it belongs to and the BeDoc version, so
+ * an edit to a helper or an upgraded dependency is a miss too.
+ *
+ * When all three still match (and every output is on disk) the file is a
+ * `hit` and can be skipped entirely. When only the format key differs the
+ * file is `partial`: the stored parse output is reused and only formatting
+ * and writing are redone. Anything else is a `miss`.
+ *
+ * Entries for inputs that are gone are dropped: when the Watcher removes a
+ * file ({@link BuildCache#forget}), and after a full run, for every input
+ * it did not look up ({@link BuildCache#prune}).
+ */
+export default class BuildCache {
+  /** @type {DirectoryObject} */
+  #directory
+
+  /** @type {DirectoryObject} */
+  #parseDirectory
+
+  /** The parse and format keys of each route. @type {Map<object, {parse: string, format: string}>} */
+  #keys
+
+  /** Recorded entries keyed by input path. */
+  #entries = {}
+
+  /** Input paths looked up since the last prune. @type {Set<string>} */
+  #seen = new Set()
+
+  #dirty = false
+
+  #stats = {hits: 0, partial: 0, misses: 0}
+
+  constructor({directory, keys}) {
+    this.#directory = directory
+    this.#parseDirectory = new DirectoryObject(path.join(directory.path, "parse"))
+    this.#keys = keys
+  }
+
+  /**
+   * Create a cache for the given negotiated routes, loading any previously
+   * persisted index.
+   *
+   * @param {object} args
+   * @param {DirectoryObject} args.directory - Where the cache lives
+   * @param {Array<object>} args.routes - The Conveyor routes (parser and
+   *   targets, with their module paths)
+   * @param {string} [args.hooks] - The hooks module path
+   * @param {string} [args.encoding] - The input encoding, which decides the
+   *   text parsers see
+   * @returns {Promise<BuildCache>} The loaded cache
+   */
+  static async new({directory, routes, hooks, encoding = "utf8"}) {
+    const [bedoc, hooksSource] = await Promise.all([
+      BuildCache.#packageOf(url.fileURLToPath(import.meta.url)),
+      BuildCache.moduleSource(hooks),
+    ])
+
+    const keys = new Map(await Promise.all(routes.map(async route => {
+      const [parser, parserTerms, ...formatters] = await Promise.all([
+        BuildCache.moduleSource(route.module),
+        BuildCache.termsSource(route.parser.meta, route.module),
+        ...route.targets.flatMap(({formatter, module}) => [
+          BuildCache.moduleSource(module),
+          BuildCache.termsSource(formatter.meta, module),
+        ]),
+      ])
+
+      const parse = BuildCache.hash(CACHE_VERSION, bedoc, parser, parserTerms, hooksSource, encoding)
+      const format = BuildCache.hash(parse, ...formatters)
+
+      return [route, {parse, format}]
+    })))
+
+    const cache = new this({directory, keys})
+
+    await cache.#load()
+
+    return cache
+  }
+
+  /**
+   * Hash any number of strings/buffers into a hex sha256 digest.
+   *
+   * @param {...(string|Buffer|number)} parts - The values to hash
+   * @returns {string} The digest
+   */
+  static hash(...parts) {
+    const hash = createHash("sha256")
+
+    // Bytes are hashed as they are; text as UTF-8, so a file hashes the same
+    // either way.
+    for(const part of parts)
+      hash.update(part instanceof Uint8Array ? part : String(part ?? "")).update("\0")
+
+    return hash.digest("hex")
+  }
+
+  /**
+   * Hash a file's bytes without loading it whole, for inputs that are
+   * streamed to their parser.
+   *
+   * @param {string} filePath - The file to hash
+   * @returns {Promise<string>} The digest
+   */
+  static async hashFile(filePath) {
+    const hash = createHash("sha256")
+
+    for await(const chunk of createReadStream(filePath))
+      hash.update(chunk)
+
+    return hash.digest("hex")
+  }
+
+  /**
+   * The identity of a module for cache keys: its package's name and
+   * version, then its own source and that of every local (relative) module
+   * it imports, statically or with a literal `import()`, transitively.
+   * Paths are taken relative to the module, so the result does not depend
+   * on where the project is checked out.
+   *
+   * @param {string} [modulePath] - The module's path
+   * @returns {Promise<string>} The module's identity, or "" if there is none
+   */
+  static async moduleSource(modulePath) {
+    if(!modulePath)
+      return ""
+
+    const root = path.resolve(modulePath)
+    const sources = new Map()
+    const pending = [root]
+
+    while(pending.length > 0) {
+      const current = pending.pop()
+
+      if(sources.has(current))
+        continue
+
+      const file = new FileObject(current)
+      const source = await file.exists ? await file.read() : ""
+
+      sources.set(current, source)
+
+      for(const [, , specifier] of source.matchAll(BuildCache.#localImport))
+        pending.push(path.resolve(path.dirname(current), specifier.split(/[?#]/)[0]))
+    }
+
+    const graph = [...sources]
+      .map(([file, source]) => [path.relative(path.dirname(root), file), source])
+      .toSorted(([a], [b]) => a.localeCompare(b))
+      .flat()
+
+    return [await BuildCache.#packageOf(root), ...graph].join("\0")
+  }
+
+  /** `from "./x"`, `import "./x"` and `import("./x")`. */
+  static #localImport = /\b(?:from|import)\s*\(?\s*(["'])(\.{1,2}\/[^"'\n]+)\1/g
+
+  /**
+   * The name and version of the package a file belongs to, from the nearest
+   * package.json above it.
+   *
+   * @param {string} filePath - The file
+   * @returns {Promise<string>} `name@version`, or "" outside any package
+   */
+  static async #packageOf(filePath) {
+    let directory = path.dirname(filePath)
+
+    for(;;) {
+      const manifest = new FileObject("package.json", new DirectoryObject(directory))
+
+      if(await manifest.exists) {
+        try {
+          const {name, version} = await manifest.loadData()
+
+          return `${name}@${version}`
+        } catch {
+          return ""
+        }
+      }
+
+      const parent = path.dirname(directory)
+
+      if(parent === directory)
+        return ""
+
+      directory = parent
+    }
+  }
+
+  /**
+   * Resolve an action's contract terms to their source text. Terms given as
+   * `ref://` are read relative to the action module; inline terms are
+   * serialised.
+   *
+   * @param {object} meta - The action's meta
+   * @param {string} modulePath - The action module path
+   * @returns {Promise<string>} The terms source
+   */
+  static async termsSource(meta, modulePath) {
+    const {terms} = meta
+
+    if(Data.isType(terms, "String") && terms.startsWith("ref://")) {
+      const module = new FileObject(modulePath)
+      const file = new FileObject(terms.slice("ref://".length), module.parent)
+
+      return await file.exists ? await file.read() : terms
+    }
+
+    return JSON.stringify(terms)
+  }
+
+  get stats() {
+    return {...this.#stats}
+  }
+
+  /**
+   * Classify a file against the cache.
+   *
+   * @param {object} ctx - The Conveyor file context (file, route, outputs and
+   *   the file's bytes as `buffer`, unless the file is streamed)
+   * @returns {Promise<{status: string, functions?: Array<object>}>} The verdict
+   */
+  async lookup(ctx) {
+    const {file, outputs, buffer} = ctx
+    const keys = this.#keys.get(ctx.route)
+    const entry = this.#entries[file.path]
+    const contentHash = buffer === undefined
+      ? await BuildCache.hashFile(file.path)
+      : BuildCache.hash(buffer)
+
+    ctx.contentHash = contentHash
+    this.#seen.add(file.path)
+
+    if(entry?.content === contentHash && entry.parse === keys.parse) {
+      if(entry.format === keys.format &&
+         BuildCache.#samePaths(entry.outputs, outputs) &&
+         await BuildCache.#allExist(outputs)) {
+        this.#stats.hits++
+
+        return {status: "hit"}
+      }
+
+      const functions = await this.#loadParse(file, contentHash, keys.parse)
+
+      if(functions) {
+        this.#stats.partial++
+
+        return {status: "partial", functions}
+      }
+    }
+
+    this.#stats.misses++
+
+    return {status: "miss"}
+  }
+
+  /**
+   * Record a successfully written file.
+   *
+   * @param {object} ctx - The Conveyor file context
+   * @returns {Promise<void>}
+   */
+  async record(ctx) {
+    const {file, outputs, contentHash, functions} = ctx
+    const keys = this.#keys.get(ctx.route)
+
+    if(!contentHash)
+      return
+
+    const previous = this.#entries[file.path]
+
+    if(previous?.content !== contentHash || previous?.parse !== keys.parse) {
+      await this.#parseDirectory.assureExists({recursive: true})
+      await this.#parseFile(file).write(JSON.stringify({
+        content: contentHash,
+        parse: keys.parse,
+        functions,
+      }))
+    }
+
+    this.#entries[file.path] = {
+      content: contentHash,
+      parse: keys.parse,
+      format: keys.format,
+      outputs: outputs.map(output => output.path),
+    }
+
+    this.#dirty = true
+  }
+
+  /**
+   * Drop a file's entry and its stored parse output, e.g. because the file
+   * was deleted.
+   *
+   * @param {FileObject} file - The input file
+   * @returns {Promise<void>}
+   */
+  async forget(file) {
+    this.#seen.delete(file.path)
+
+    if(!(file.path in this.#entries))
+      return
+
+    delete this.#entries[file.path]
+    await rm(this.#parseFile(file).path, {force: true})
+
+    this.#dirty = true
+  }
+
+  /**
+   * Drop every entry not looked up since the last prune, and any stored
+   * parse output no entry refers to, then save. Only meaningful after a run
+   * over the whole input set, where an input not looked up no longer
+   * exists (or is no longer an input).
+   *
+   * @returns {Promise<void>}
+   */
+  async prune() {
+    for(const filePath of Object.keys(this.#entries)) {
+      if(!this.#seen.has(filePath)) {
+        delete this.#entries[filePath]
+        this.#dirty = true
+      }
+    }
+
+    this.#seen.clear()
+
+    if(await this.#parseDirectory.exists) {
+      const kept = new Set(Object.keys(this.#entries)
+        .map(filePath => this.#parseFile({path: filePath}).path))
+      const {files} = await this.#parseDirectory.read()
+
+      await Promise.all(files
+        .filter(stored => !kept.has(stored.path))
+        .map(stored => rm(stored.path, {force: true})))
+    }
+
+    await this.save()
+  }
+
+  /**
+   * Persist the index if anything changed.
+   *
+   * @returns {Promise<void>}
+   */
+  async save() {
+    if(!this.#dirty)
+      return
+
+    await this.#directory.assureExists({recursive: true})
+    await this.#indexFile.write(JSON.stringify({
+      version: CACHE_VERSION,
+      entries: this.#entries,
+    }))
+
+    this.#dirty = false
+  }
+
+  static #samePaths(paths, outputs) {
+    return Array.isArray(paths) &&
+      paths.length === outputs.length &&
+      paths.every((entry, index) => entry === outputs[index].path)
+  }
+
+  static async #allExist(outputs) {
+    const exists = await Promise.all(outputs.map(output => output.exists))
+
+    return exists.every(Boolean)
+  }
+
+  get #indexFile() {
+    return new FileObject("index.json", this.#directory)
+  }
+
+  #parseFile(file) {
+    return new FileObject(`${BuildCache.hash(file.path)}.json`, this.#parseDirectory)
+  }
+
+  async #load() {
+    const index = this.#indexFile
+
+    if(!await index.exists)
+      return
+
+    try {
+      const data = await index.loadData()
+
+      if(data?.version === CACHE_VERSION && Data.isPlainObject(data.entries))
+        this.#entries = data.entries
+    } catch {
+      // A corrupt index is no worse than an empty one.
+      this.#entries = {}
+    }
+  }
+
+  async #loadParse(file, contentHash, parseKey) {
+    const stored = this.#parseFile(file)
+
+    if(!await stored.exists)
+      return null
+
+    try {
+      const data = await stored.loadData()
+
+      return data?.content === contentHash && data.parse === parseKey
+        ? data.functions
+        : null
+    } catch {
+      return null
+    }
+  }
+}
@@ -34,13 +34,27 @@ function supportsUnicode() {
   return process.env.TERM !== "linux"
 }
 
+/** Control sequences used for in-place repainting. */
+const CSI = "\x1b["
+const CLEAR_LINE = `${CSI}K`
+const CLEAR_BELOW = `${CSI}J`
+const RESET = `${CSI}0m`
+const moveTo = row => `${CSI}${row};1H`
+
 /**
  * Handles CLI output for the BeDoc pipeline, rendering progress and status
  * for each file as it moves through the read → parse → validate → format →
  * write stages.
  *
  * Listens to a {@link Notify} instance and tracks per-file state in an
- * internal map so that output can be updated in-place as each stage completes.
+ * internal map. Updates only record state and mark it dirty; the live view is
+ * painted on a frame timer, so its cost is bounded by the frame rate rather
+ * than by files × events. Each frame shows a line of summary counters and a
+ * terminal-sized window of file blocks starting at the first unfinished
+ * file, and rewrites only the screen rows whose text changed since the
+ * previous frame. Rows are cut to the terminal's width, so each line is
+ * exactly one screen row, and a resize repaints the whole view.
+ * {@link CLIOutput#render} draws every file in full, for the final report.
  *
  * Each file is drawn as a framed block: an Input line (top border), one line
  * per pipeline stage, and an Output line (bottom border). Colour is emitted
@@ -66,13 +80,46 @@ export default class CLIOutput  {
    */
   #files = new Map()
 
-  constructor({config}) {
+  /** Tracked files in the order they were queued, for windowing. */
+  #order = []
+
+  /** Index into #order of the first file that has not finished. */
+  #cursor = 0
+
+  /** How many tracked files are in each summary status. */
+  #counts = {}
+
+  /** Milliseconds between live frames. */
+  #frameInterval
+
+  /** The pending frame timer, if one is scheduled. */
+  #frame = null
+
+  /** The rows painted by the last live frame; null forces a full repaint. */
+  #screen = null
+
+  /**
+   * Constructor for CLIOutput.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {object} arg.config - The resolved configuration
+   * @param {number} [arg.frameInterval] - Milliseconds between live frames
+   */
+  constructor({config, frameInterval = 100}) {
     this.#basePath = config.basePath
     this.#terse = Boolean(config.terse)
+    this.#frameInterval = frameInterval
 
     Notify.on("conveyor-start", this.#conveyorStart)
+    Notify.on("conveyor-queue", this.#conveyorQueue)
     Notify.on("update-data", this.#updateData)
 
+    // A resized terminal may have reflowed; repaint in full, now.
+    process.stdout.on("resize", () => {
+      this.#screen = null
+      this.#schedule()
+    })
+
     c.alias.set("border", "{F033}")
     c.alias.set("fileName", "{<B}")
     c.alias.set("fileSize", "{F070}")
@@ -84,25 +131,49 @@ export default class CLIOutput  {
   }
 
   /**
-   * Seeds the tracking map when the conveyor announces its work set.
+   * Clears the tracking map when the conveyor starts. Any previous run's
+   * files are dropped, so repeated runs (watch mode) only show the current
+   * batch.
+   */
+  #conveyorStart = () => {
+    this.#files.clear()
+    this.#order = []
+    this.#cursor = 0
+    this.#counts = {pending: 0, active: 0, success: 0, warning: 0, error: 0}
+    this.#screen = null
+
+    this.#schedule()
+  }
+
+  /**
+   * Tracks a file the conveyor has taken on. Files arrive as the input set
+   * is enumerated, so the total grows while the run goes.
    *
-   * @param {Array<object>} ctx - One entry per file, each {file, output}.
+   * @param {object} ctx - The file's context, {file, output, outputs}.
    */
-  #conveyorStart = ctx => {
-    ctx.forEach(e => this.#files.set(e.file, {
-      output: e.output,
+  #conveyorQueue = ctx => {
+    const item = {
+      file: ctx.file,
+      outputs: ctx.outputs ?? [ctx.output],
+      status: "pending",
       stages: Object.fromEntries(this.#stages.map(s => [s, "pending"])),
       size: {
         input: undefined, // undefined = pending, null = err, 0 = warning, number = success
         output: undefined, // undefined = pending, null = err, 0 = warning, number = success
       }
-    }))
+    }
+
+    this.#files.set(ctx.file, item)
+    this.#order.push(item)
+    this.#counts.pending++
+
+    this.#schedule()
   }
 
   /**
-   * Applies a single update for a file and re-renders. Messages are either a
-   * size update ({kind: "input-size"|"output-size", value}) or a stage
-   * transition ({kind: "stage", stage, state}).
+   * Applies a single update for a file and schedules a frame. Messages are
+   * either a size update ({kind: "input-size"|"output-size", value}) or a
+   * stage transition ({kind: "stage", stage, state}).
    *
    * @param {object} update - The update payload.
    * @param {object} update.file - The file the update pertains to.
@@ -128,7 +199,171 @@ export default class CLIOutput  {
         break
     }
 
-    this.render()
+    const status = this.#status(item)
+
+    if(status !== item.status) {
+      this.#counts[item.status]--
+      this.#counts[status]++
+      item.status = status
+    }
+
+    this.#schedule()
+  }
+
+  /**
+   * Derives a file's summary status from its stages and sizes.
+   *
+   * @param {object} item - The tracked file state.
+   * @returns {string} One of pending|active|success|warning|error.
+   */
+  #status({stages, size}) {
+    const states = Object.values(stages)
+
+    if(size.input === null || size.output === null || states.includes("error"))
+      return "error"
+
+    if(size.output === 0 || states.includes("warning"))
+      return "warning"
+
+    if(size.output !== undefined)
+      return "success"
+
+    return states.some(state => state !== "pending") ? "active" : "pending"
+  }
+
+  /** Arms the frame timer unless a frame is already pending. */
+  #schedule() {
+    if(this.#frame)
+      return
+
+    this.#frame = setTimeout(this.#paint, this.#frameInterval)
+    this.#frame.unref?.()
+  }
+
+  /** Cancels any pending frame. */
+  #cancel() {
+    clearTimeout(this.#frame)
+    this.#frame = null
+  }
+
+  /**
+   * Paints one live frame: the summary counters and as many file blocks as
+   * fit the terminal, starting at the first unfinished file. Only rows that
+   * differ from the previous frame are written.
+   */
+  #paint = () => {
+    this.#frame = null
+
+    const order = this.#order
+
+    while(this.#cursor < order.length && this.#finished(order[this.#cursor]))
+      this.#cursor++
+
+    const height = Math.max(3, (process.stdout.rows ?? 24) - 1)
+    const rows = [this.#summary()]
+
+    for(let i = this.#cursor; i < order.length; i++) {
+      const block = this.#block(order[i])
+
+      if(rows.length + block.length > height)
+        break
+
+      rows.push(...block)
+    }
+
+    const width = process.stdout.columns ?? 80
+    const painted = rows.map(row => CLIOutput.#fit(this.#colour(row), width))
+    const previous = this.#screen
+    let out = ""
+
+    if(!previous) {
+      Term.cls()
+      out = painted.map(row => `${row}${CLEAR_LINE}`).join("\n")
+    } else {
+      painted.forEach((row, i) => {
+        if(row !== previous[i])
+          out += `${moveTo(i + 1)}${row}${CLEAR_LINE}`
+      })
+
+      if(painted.length < previous.length)
+        out += `${moveTo(painted.length + 1)}${CLEAR_BELOW}`
+    }
+
+    this.#screen = painted
+
+    if(out)
+      Term.write(out)
+  }
+
+  /**
+   * Cuts a painted row to the given number of columns, so it cannot wrap
+   * onto the next screen row. Escape sequences take no columns and are
+   * kept; a cut row ends with a colour reset. The last column is left
+   * free, as writing into it leaves some terminals pending a wrap.
+   *
+   * @param {string} row - The row, with any colour escapes.
+   * @param {number} width - The terminal's width in columns.
+   * @returns {string} The row as it fits.
+   */
+  static #fit(row, width) {
+    let columns = 0
+    let index = 0
+
+    while(index < row.length) {
+      if(row.startsWith(CSI, index)) {
+        // Skip to the sequence's final byte (@ through ~).
+        index += CSI.length
+
+        while(index < row.length && !/[@-~]/.test(row[index]))
+          index++
+
+        index++
+
+        continue
+      }
+
+      if(columns === width - 1)
+        return `${row.slice(0, index)}${Term.hasColor ? RESET : ""}`
+
+      index += row.codePointAt(index) > 0xffff ? 2 : 1
+      columns++
+    }
+
+    return row
+  }
+
+  #finished({status}) {
+    return status === "success" || status === "warning" || status === "error"
+  }
+
+  /**
+   * The summary counters line.
+   *
+   * @returns {string} The (uncoloured template) line.
+   */
+  #summary() {
+    const {pending, active, success, warning, error} = this.#counts
+    const finished = success + warning + error
+
+    return `{fileName}${finished.toLocaleString()}/${this.#order.length.toLocaleString()}{B>} files` +
+      `  {pending}${this.#g.active}{/} ${active} active` +
+      `  {pending}${this.#g.pending}{/} ${pending} pending` +
+      `  {success}${this.#g.success}{/} ${success} done` +
+      `  {warning}${this.#g.warning}{/} ${warning} warned` +
+      `  {error}${this.#g.error}{/} ${error} errored`
+  }
+
+  /**
+   * Applies the colour template to a line, stripping the escapes again when
+   * the terminal has no colour.
+   *
+   * @param {string} line - A line using the colour aliases.
+   * @returns {string} The line ready to write.
+   */
+  #colour(line) {
+    const out = c`${line}`
+
+    return Term.hasColor ? out : stripVTControlCharacters(out)
   }
 
   /**
@@ -167,28 +402,51 @@ export default class CLIOutput  {
     return `{success}${this.#g.success}{/}`
   }
 
-  render(cls=true) {
+  /**
+   * The lines of one file's framed block.
+   *
+   * @param {object} item - The tracked file state.
+   * @returns {Array<string>} The (uncoloured template) lines.
+   */
+  #block({file, outputs, stages, size}) {
     const lines = []
+    const srcRel = FS.toRelativePath(this.#basePath.path, file.path)
+    const outRel = outputs
+      .map(output => FS.toRelativePath(this.#basePath.path, output.path))
+      .join("{/}, {fileName}")
+    const done = size.output !== undefined
 
-    for(const [file, {output, stages, size}] of this.#files) {
-      const srcRel = FS.toRelativePath(this.#basePath.path, file.path)
-      const outRel = FS.toRelativePath(this.#basePath.path, output.path)
-      const done = size.output !== undefined
+    lines.push(
+      `{border}${done ? this.#g.upperDone : this.#g.upper}{/}${this.#sizeMarker(size.input)} Input {fileName}${srcRel}{B>}` +
+      (size.input ? ` ({fileSize}${size.input.toLocaleString()}{/} bytes)` : "")
+    )
 
-      lines.push(
-        `{border}${done ? this.#g.upperDone : this.#g.upper}{/}${this.#sizeMarker(size.input)} Input {fileName}${srcRel}{B>}` +
-        (size.input ? ` ({fileSize}${size.input.toLocaleString()}{/} bytes)` : "")
-      )
+    if(!this.#terse)
+      for(const stage of this.#stages)
+        lines.push(`{border}${this.#g.mid}{/}  ${this.#marker(stages[stage])} ${stage}`)
 
-      if(!this.#terse)
-        for(const stage of this.#stages)
-          lines.push(`{border}${this.#g.mid}{/}  ${this.#marker(stages[stage])} ${stage}`)
+    lines.push(
+      `{border}${done ? this.#g.lowerDone : this.#g.lower}{/}${this.#sizeMarker(size.output)} Output {fileName}${outRel}{/}` +
+      (size.output ? ` ({fileSize}${size.output.toLocaleString()}{/} bytes)` : "")
+    )
 
-      lines.push(
-        `{border}${done ? this.#g.lowerDone : this.#g.lower}{/}${this.#sizeMarker(size.output)} Output {fileName}${outRel}{/}` +
-        (size.output ? ` ({fileSize}${size.output.toLocaleString()}{/} bytes)` : "")
-      )
-    }
+    return lines
+  }
+
+  /**
+   * Draws every tracked file in full, followed by the summary counters.
+   * Cancels any pending live frame; the next live frame repaints from a
+   * clear screen.
+   *
+   * @param {boolean} [cls] - Whether to clear the screen first.
+   */
+  render(cls=true) {
+    this.#cancel()
+    this.#screen = null
+
+    const lines = this.#order.flatMap(item => this.#block(item))
+
+    lines.push(this.#summary())
 
     const out = c`${lines.join("\n")}\n`
 
@@ -0,0 +1,161 @@
+import {monitorEventLoopDelay, performance} from "node:perf_hooks"
+
+/**
+ * Decides how many files {@link Conveyor} keeps in flight.
+ *
+ * In fixed mode the limit is simply `max`. In adaptive mode the controller
+ * starts low and, once per measurement window, compares the window's
+ * throughput (files finished per second) with the previous one, while
+ * watching event-loop lag:
+ *
+ * - event-loop lag over `maxLag` means the main thread is saturated, so the
+ *   limit is cut multiplicatively;
+ * - if the last increase bought no more throughput, the extra files were
+ *   only adding latency (queueing on the disk, the CPU or a remote hook),
+ *   so the limit steps back down;
+ * - otherwise the limit grows additively towards `max`.
+ *
+ * After a cut or a step back the limit holds for a few windows before
+ * probing upwards again, so it settles near the knee of the throughput
+ * curve instead of oscillating. `max` is a hard ceiling and `min` a floor.
+ */
+export default class ConcurrencyController {
+  #adaptive
+  #min
+  #max
+  #limit
+
+  /** Milliseconds per measurement window. */
+  #window
+
+  /** Mean event-loop lag, in milliseconds, above which to back off. */
+  #maxLag
+
+  /** @type {import("node:perf_hooks").IntervalHistogram|null} */
+  #lag = null
+
+  #windowStart = 0
+  #completed = 0
+
+  /** The previous window's throughput, once measured. */
+  #previous = null
+
+  /** +1 after an increase, -1 after a decrease, 0 otherwise. */
+  #lastStep = 0
+
+  /** Windows left to hold the limit before probing again. */
+  #hold = 0
+
+  #peak
+  #adjustments = 0
+
+  /**
+   * Constructor for ConcurrencyController.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {number} arg.max - The fixed limit, or the adaptive ceiling
+   * @param {boolean} [arg.adaptive] - Whether to adapt the limit
+   * @param {number} [arg.min] - The adaptive floor
+   * @param {number} [arg.window] - Milliseconds per measurement window
+   * @param {number} [arg.maxLag] - Mean event-loop lag (ms) treated as
+   *   saturation
+   */
+  constructor({max, adaptive = false, min = 1, window = 250, maxLag = 30}) {
+    this.#adaptive = adaptive
+    this.#max = Math.max(1, max)
+    this.#min = Math.min(Math.max(1, min), this.#max)
+    this.#limit = adaptive
+      ? Math.min(this.#max, Math.max(this.#min, 2))
+      : this.#max
+    this.#window = window
+    this.#maxLag = maxLag
+    this.#peak = this.#limit
+  }
+
+  /** The number of files that may currently be in flight. */
+  get limit() {
+    return this.#limit
+  }
+
+  /** Begin measuring. */
+  start() {
+    if(!this.#adaptive)
+      return
+
+    this.#lag = monitorEventLoopDelay({resolution: 10})
+    this.#lag.enable()
+    this.#windowStart = performance.now()
+  }
+
+  /** Stop measuring. */
+  stop() {
+    this.#lag?.disable()
+    this.#lag = null
+  }
+
+  /** Record a finished file and, at the end of a window, adjust the limit. */
+  complete() {
+    if(!this.#lag)
+      return
+
+    this.#completed++
+
+    const now = performance.now()
+    const elapsed = now - this.#windowStart
+
+    if(elapsed < this.#window)
+      return
+
+    const throughput = this.#completed / (elapsed / 1000)
+    const lag = this.#lag.mean / 1e6
+
+    this.#adjust({throughput, lag})
+
+    this.#previous = throughput
+    this.#completed = 0
+    this.#windowStart = now
+    this.#lag.reset()
+  }
+
+  #adjust({throughput, lag}) {
+    let next = this.#limit
+
+    if(lag > this.#maxLag) {
+      next = Math.floor(this.#limit * 0.75)
+      this.#hold = 4
+    } else if(this.#hold > 0) {
+      this.#hold--
+    } else if(this.#lastStep > 0 && throughput <= this.#previous * 1.05) {
+      next = this.#limit - 1
+      this.#hold = 4
+    } else {
+      next = this.#limit + 1
+    }
+
+    next = Math.min(this.#max, Math.max(this.#min, next))
+
+    this.#lastStep = Math.sign(next - this.#limit)
+
+    if(next !== this.#limit) {
+      this.#adjustments++
+      this.#limit = next
+      this.#peak = Math.max(this.#peak, next)
+    }
+  }
+
+  /**
+   * Summarise the controller's behaviour over the run.
+   *
+   * @returns {{adaptive: boolean, limit: number, peak: number, max: number, adjustments: number}}
+   *   The mode, final and peak limits, ceiling and number of adjustments
+   */
+  summary() {
+    return {
+      adaptive: this.#adaptive,
+      limit: this.#limit,
+      peak: this.#peak,
+      max: this.#max,
+      adjustments: this.#adjustments,
+    }
+  }
+}
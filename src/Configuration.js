@@ -1,4 +1,4 @@
-import {Collection, Data, DirectoryObject, FileObject, FileSystem as FS, Promised, Sass, Tantrum} from "@gesslar/toolkit"
+import {Collection, Data, DirectoryObject, FileObject, FileSystem as FS, Sass, Tantrum} from "@gesslar/toolkit"
 import JSON5 from "json5"
 import process from "node:process"
 
@@ -7,6 +7,8 @@ import {
   ConfigurationPriorityKeys,
 } from "./ConfigurationParameters.js"
 import Environment from "./Environment.js"
+import InputSource from "./InputSource.js"
+import SourceReader from "./SourceReader.js"
 
 export default class Configuration {
   async validate({options, source}) {
@@ -101,40 +103,76 @@ export default class Configuration {
           continue
       }
 
-      // Additional path validation if needed
-      if(path && !nothing) {
-        const {mustExist, type: pathType} = path
+      if(key === "targets") {
+        if(finalOptions.formatter)
+          throw new SyntaxError("Options `targets` and `formatter` are mutually exclusive")
 
-        // `input` and `exclude` are glob patterns (or arrays of them). Each
-        // is resolved against the base directory via DirectoryObject's glob.
-        if(key === "input" || key === "exclude") {
-          if(!Data.isType(value, "Array") && !Data.isType(value, "String")) {
-            throw new TypeError(
-              `Option \`${key}\` must be a string or an array of strings`,
-            )
-          }
+        finalOptions[key] = this.#resolveTargets(value, finalOptions.output)
+
+        continue
+      }
+
+      if(key === "routes") {
+        finalOptions[key] = this.#resolveRoutes(value)
+
+        continue
+      }
 
-          const patterns = Data.isType(value, "Array") ? value : [value]
+      if(key === "encoding") {
+        if(!SourceReader.supports(value))
+          throw new SyntaxError(`Unsupported encoding \`${value}\``)
 
-          const settled = await Promised.settle(
-            patterns.map(async pat => {
-              const {files} = await base.glob(pat)
+        finalOptions[key] = value
+
+        continue
+      }
+
+      if(key === "stages") {
+        finalOptions[key] = this.#resolveStages(value)
+
+        continue
+      }
+
+      if(key === "shard") {
+        finalOptions[key] = this.#resolveShard(value)
+
+        continue
+      }
 
-              return files
-            })
+      // `input` and `exclude` are glob patterns (or arrays of them), relative
+      // to the base directory. They are not expanded here: `input` becomes an
+      // InputSource, which enumerates the files (less the excludes, and only
+      // this shard's share, both of which come first) when a run starts.
+      if(key === "input" || key === "exclude") {
+        if(!Data.isType(value, "Array") && !Data.isType(value, "String")) {
+          throw new TypeError(
+            `Option \`${key}\` must be a string or an array of strings`,
           )
+        }
 
-          value = Promised.values(settled).flat()
+        const patterns = Data.isType(value, "Array") ? value : [value]
 
-          finalOptions[key] = value
+        finalOptions[key] = key === "input"
+          ? new InputSource({
+            basePath: base,
+            patterns,
+            exclude: finalOptions.excludePatterns,
+            shard: finalOptions.shard,
+          })
+          : patterns
+        finalOptions[`${key}Patterns`] = patterns
 
-          continue
-        } else {
-          if(mustExist === true) {
-            finalOptions[key] = pathType === FS.fdType.FILE
-              ? new FileObject(value)
-              : new DirectoryObject(value)
-          }
+        continue
+      }
+
+      // Additional path validation if needed
+      if(path && !nothing) {
+        const {mustExist, type: pathType} = path
+
+        if(mustExist === true) {
+          finalOptions[key] = pathType === FS.fdType.FILE
+            ? new FileObject(value)
+            : new DirectoryObject(value)
         }
       }
     }
@@ -147,6 +185,153 @@ export default class Configuration {
     }
   }
 
+  /**
+   * Normalise the `targets` option into one entry per output format. Each
+   * target is given as `format=dir` (a string, or comma-separated strings)
+   * or as an object naming either a `format` or a `formatter` module, and an
+   * `output` directory, which defaults to the `output` option.
+   *
+   * @param {string|Array<string|object>} value - The option value
+   * @param {DirectoryObject} [output] - The `output` option, if given
+   * @returns {Array<{format?: string, formatter?: FileObject, output: DirectoryObject}>}
+   *   The targets
+   */
+  #resolveTargets(value, output) {
+    const entries = (Data.isType(value, "Array") ? value : [value])
+      .flatMap(entry => Data.isType(entry, "String")
+        ? entry.split(",").map(pair => pair.trim()).filter(Boolean)
+        : [entry])
+
+    const targets = entries.map(entry => {
+      let spec = entry
+
+      if(Data.isType(entry, "String")) {
+        const [format, dir] = entry.split("=").map(part => part.trim())
+
+        spec = {format, output: dir || undefined}
+      }
+
+      if(!Data.isPlainObject(spec) || Boolean(spec.format) === Boolean(spec.formatter))
+        throw new SyntaxError(`Target \`${JSON.stringify(entry)}\` must name exactly one of \`format\` or \`formatter\``)
+
+      const dir = spec.output ?? output
+
+      if(!dir)
+        throw new SyntaxError(`Target \`${spec.format ?? spec.formatter}\` has no output directory`)
+
+      return {
+        ...(spec.format ? {format: spec.format} : {formatter: new FileObject(spec.formatter)}),
+        output: Data.isType(dir, "DirectoryObject") ? dir : new DirectoryObject(dir),
+      }
+    })
+
+    if(targets.length === 0)
+      throw new SyntaxError("Option `targets` names no targets")
+
+    return targets
+  }
+
+  /**
+   * Normalise the `routes` option into one entry per parser. Each route is
+   * given as `glob=language` (a string, or comma-separated strings; commas
+   * inside `{…}` belong to the glob) or as an object with `input` (a glob or
+   * array of globs, relative to the base path) and exactly one of `language`
+   * or `parser`.
+   *
+   * @param {string|Array<string|object>} value - The option value
+   * @returns {Array<{input: Array<string>, language?: string, parser?: FileObject}>}
+   *   The routes
+   */
+  #resolveRoutes(value) {
+    const entries = (Data.isType(value, "Array") ? value : [value])
+      .flatMap(entry => Data.isType(entry, "String")
+        ? entry.split(/,(?![^{]*\})/).map(pair => pair.trim()).filter(Boolean)
+        : [entry])
+
+    const routes = entries.map(entry => {
+      let spec = entry
+
+      if(Data.isType(entry, "String")) {
+        const at = entry.lastIndexOf("=")
+
+        spec = at < 0
+          ? {input: entry}
+          : {input: entry.slice(0, at).trim(), language: entry.slice(at + 1).trim()}
+      }
+
+      const input = [spec?.input].flat().filter(Boolean)
+
+      if(!Data.isPlainObject(spec) || input.length === 0 ||
+         Boolean(spec.language) === Boolean(spec.parser))
+        throw new SyntaxError(`Route \`${JSON.stringify(entry)}\` must have \`input\` and exactly one of \`language\` or \`parser\``)
+
+      return {
+        input,
+        ...(spec.language ? {language: spec.language} : {parser: new FileObject(spec.parser)}),
+      }
+    })
+
+    if(routes.length === 0)
+      throw new SyntaxError("Option `routes` names no routes")
+
+    return routes
+  }
+
+  /**
+   * Normalise the `stages` option into per-stage pool limits. Limits are
+   * given as `stage=num` (comma-separated) or as an object; stages left out
+   * keep Conveyor's defaults.
+   *
+   * @param {string|object} value - The option value
+   * @returns {{read?: number, parse?: number, format?: number, write?: number}}
+   *   The limits
+   */
+  #resolveStages(value) {
+    const spec = Data.isType(value, "String")
+      ? Object.fromEntries(value.split(",")
+        .map(pair => pair.trim())
+        .filter(Boolean)
+        .map(pair => pair.split("=").map(part => part.trim())))
+      : value
+
+    if(!Data.isPlainObject(spec))
+      throw new SyntaxError("Option `stages` must be stage=num pairs or an object")
+
+    const stages = {}
+
+    for(const [stage, limit] of Object.entries(spec)) {
+      if(!["read", "parse", "format", "write"].includes(stage))
+        throw new SyntaxError(`Unknown stage \`${stage}\` in option \`stages\` (expected read, parse, format or write)`)
+
+      const number = Number(limit)
+
+      if(!Number.isInteger(number) || number < 1)
+        throw new SyntaxError(`Stage \`${stage}\` must have a whole number limit of at least 1`)
+
+      stages[stage] = number
+    }
+
+    return stages
+  }
+
+  /**
+   * Normalise the `shard` option, given as `index/count` (1-based) or as an
+   * object.
+   *
+   * @param {string|object} value - The option value
+   * @returns {{index: number, count: number}} The shard
+   */
+  #resolveShard(value) {
+    const [index, count] = Data.isType(value, "String")
+      ? value.split("/").map(part => Number(part.trim()))
+      : [Number(value?.index), Number(value?.count)]
+
+    if(!Number.isInteger(index) || !Number.isInteger(count) || count < 1 || index < 1 || index > count)
+      throw new SyntaxError(`Option \`shard\` must be index/count with 1 <= index <= count, not \`${Data.isType(value, "String") ? value : JSON.stringify(value)}\``)
+
+    return {index, count}
+  }
+
   #mapEntryOptions({options = {}, source}) {
     // CLI already has done all the work via commander
     if(source === Environment.CLI)
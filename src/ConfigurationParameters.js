@@ -27,6 +27,13 @@ const ConfigurationParameters = Data.deepFreezeObject({
     required: false,
     exclusiveOf: "parser",
   },
+  routes: {
+    short: "r",
+    param: "list",
+    description: "Route inputs to parsers: glob=language pairs, comma-separated, or {input, language|parser} objects",
+    type: Data.newTypeSpec("string|string[]|object[]"),
+    required: false,
+  },
   format: {
     short: "f",
     description: "Output format",
@@ -34,14 +41,52 @@ const ConfigurationParameters = Data.deepFreezeObject({
     required: false,
     exclusiveOf: "formatter",
   },
+  targets: {
+    short: "F",
+    param: "list",
+    description: "Format several ways from one parse: format=dir pairs, comma-separated, or {format|formatter, output} objects",
+    type: Data.newTypeSpec("string|string[]|object[]"),
+    required: false,
+    exclusiveOf: "format",
+  },
   maxConcurrent: {
     short: "C",
     param: "num",
-    description: "Maximum number of concurrent tasks",
+    description: "Maximum number of concurrent tasks (the ceiling when adaptive)",
     type: Data.newTypeSpec("number"),
     required: false,
     default: 10,
   },
+  adaptive: {
+    short: "A",
+    description: "Adapt the number of files in flight to measured throughput, up to maxConcurrent",
+    type: Data.newTypeSpec("boolean"),
+    required: false,
+    default: false,
+  },
+  stages: {
+    short: "S",
+    param: "list",
+    description: "Files each stage pool works on at once: stage=num pairs, comma-separated (read, parse, format, write), or an object. Defaults to maxConcurrent, except parse (half of it) and, with workers, parse and format (one per worker)",
+    type: Data.newTypeSpec("string|object"),
+    required: false,
+  },
+  workers: {
+    short: "w",
+    param: "num",
+    description: "Worker threads for parsing and formatting (0 = main thread)",
+    type: Data.newTypeSpec("number"),
+    required: false,
+    default: 0,
+  },
+  encoding: {
+    short: "E",
+    param: "label",
+    description: "Character encoding of input files (e.g. utf8, latin1, windows-1252)",
+    type: Data.newTypeSpec("string"),
+    required: false,
+    default: "utf8",
+  },
   hooks: {
     short: "k",
     param: "file",
@@ -91,11 +136,56 @@ const ConfigurationParameters = Data.deepFreezeObject({
   hookTimeout: {
     short: "T",
     param: "ms",
-    description: "Timeout in milliseconds for hook execution",
+    description: "Timeout in milliseconds for each Parse and Format hook call (the Run hook's after$run is exempt)",
     type: Data.newTypeSpec("number"),
     required: false,
     default: 5000,
   },
+  cache: {
+    short: "K",
+    description: "Use the persistent incremental build cache",
+    type: Data.newTypeSpec("boolean"),
+    required: false,
+    default: false,
+  },
+  cacheDir: {
+    param: "dir",
+    description: "Directory for BeDoc's persistent caches (build cache, action discovery index)",
+    type: Data.newTypeSpec("string"),
+    required: false,
+    default: ".bedoc-cache",
+    path: {
+      type: "directory",
+      mustExist: true,
+    },
+  },
+  rebuildDiscovery: {
+    description: "Ignore and rebuild the cached action discovery index",
+    type: Data.newTypeSpec("boolean"),
+    required: false,
+    default: false,
+  },
+  shard: {
+    param: "index/count",
+    description: "Process only this shard (1-based) of the input, split by file size across count machines",
+    type: Data.newTypeSpec("string|object"),
+    required: false,
+    exclusiveOf: "watch",
+  },
+  watch: {
+    short: "W",
+    description: "Keep running and regenerate docs when inputs change",
+    type: Data.newTypeSpec("boolean"),
+    required: false,
+    default: false,
+  },
+  watchDelay: {
+    param: "ms",
+    description: "Milliseconds to wait for changes to settle in watch mode",
+    type: Data.newTypeSpec("number"),
+    required: false,
+    default: 100,
+  },
   mock: {
     short: "m",
     param: "dir",
@@ -141,6 +231,27 @@ const ConfigurationParameters = Data.deepFreezeObject({
     required: false,
     default: 0,
   },
+  report: {
+    short: "R",
+    param: "file",
+    description: "Write a run report: NDJSON, JSON if the file ends in .json, or NDJSON on stdout for -",
+    type: Data.newTypeSpec("string"),
+    required: false,
+  },
+  skipUnchanged: {
+    short: "u",
+    description: "Leave outputs that are byte-identical to the new output unwritten",
+    type: Data.newTypeSpec("boolean"),
+    required: false,
+    default: false,
+  },
+  manifest: {
+    short: "M",
+    param: "file",
+    description: "Write a JSON manifest of created, updated, unchanged and orphaned outputs",
+    type: Data.newTypeSpec("string"),
+    required: false,
+  },
   terse: {
     short: "t",
     description: "Terse output (hide per-stage progress lines)",
@@ -150,7 +261,7 @@ const ConfigurationParameters = Data.deepFreezeObject({
   },
 })
 
-const ConfigurationPriorityKeys = Data.deepFreezeObject(["exclude", "input"])
+const ConfigurationPriorityKeys = Data.deepFreezeObject(["exclude", "shard", "input"])
 
 export {
   ConfigurationParameters,
@@ -0,0 +1,68 @@
+import {Contract} from "@gesslar/negotiator"
+
+import BuildCache from "./BuildCache.js"
+
+/**
+ * @import {FileObject} from "@gesslar/toolkit"
+ */
+
+/** Bump when the key derivation changes. */
+const CACHE_VERSION = 1
+
+/**
+ * Negotiated contracts, keyed by the hash of both sides' terms sources.
+ * Shared by every BeDoc instance in the process, so a pair is only ever
+ * negotiated (and its schemas compiled) once no matter how many runs,
+ * formatters or routes ask for it.
+ *
+ * @type {Map<string, Promise<Contract>>}
+ */
+const negotiated = new Map()
+
+/**
+ * Caches the outcome of {@link Contract.negotiate} for parser × formatter
+ * pairs, in memory, for the life of the process (e.g. across watch-mode
+ * runs). A failed negotiation is not kept, so it is attempted, and its
+ * error reported, every time the pair is asked for.
+ *
+ * Nothing is persisted: the only way to get a Contract is to negotiate it,
+ * so a verdict on disk would save nothing on a cold start.
+ */
+export default class ContractCache {
+  /**
+   * The cache key for a discovered parser and formatter.
+   *
+   * @param {{file: FileObject, action: object}} parser - The parser definition
+   * @param {{file: FileObject, action: object}} formatter - The formatter definition
+   * @returns {Promise<string>} The key
+   */
+  async key(parser, formatter) {
+    const [provides, consumes] = await Promise.all([
+      BuildCache.termsSource(parser.action.default.meta, parser.file.path),
+      BuildCache.termsSource(formatter.action.default.meta, formatter.file.path),
+    ])
+
+    return BuildCache.hash(CACHE_VERSION, provides, consumes)
+  }
+
+  /**
+   * Negotiate (or reuse) the contract for a pair.
+   *
+   * @param {string} key - The pair's key
+   * @param {object} provides - The parser's terms
+   * @param {object} consumes - The formatter's terms
+   * @returns {Promise<Contract>} The negotiated contract
+   */
+  async negotiate(key, provides, consumes) {
+    if(!negotiated.has(key))
+      negotiated.set(key, Contract.negotiate(provides, consumes))
+
+    try {
+      return await negotiated.get(key)
+    } catch(error) {
+      negotiated.delete(key)
+
+      throw error
+    }
+  }
+}
@@ -1,7 +1,21 @@
 import {ActionBuilder, ActionRunner, ACTIVITY} from "@gesslar/actioneer"
 import {DirectoryObject, FileObject, Notify, Sass} from "@gesslar/toolkit"
+import fs from "node:fs/promises"
+import path from "node:path"
+import {performance} from "node:perf_hooks"
+
+import ConcurrencyController from "./ConcurrencyController.js"
+import Hooks from "./Hooks.js"
+import OutputManifest from "./OutputManifest.js"
+import OutputWriter from "./OutputWriter.js"
+import PipelineCache from "./PipelineCache.js"
+import RunMetrics from "./RunMetrics.js"
+import SourceReader from "./SourceReader.js"
+import StagePool from "./StagePool.js"
+import WorkerPool from "./WorkerPool.js"
 
 /**
+ * @import {BuildCache} from "./BuildCache.js"
  * @import {CLIOutput} from "./CLIOutput.js"
  * @import {Contract} from "@gesslar/negotiator"
  */
@@ -9,47 +23,182 @@ import {DirectoryObject, FileObject, Notify, Sass} from "@gesslar/toolkit"
 const {IF} = ACTIVITY
 
 export default class Conveyor {
-  #parser
-  #formatter
+  /**
+   * The parser routes. Each file goes to the first route whose `input` globs
+   * match it (a route without globs matches anything), and is parsed by that
+   * route's parser. Its parse result then goes to each of the route's
+   * targets: a formatter, its contract with the parser, and its output
+   * directory.
+   *
+   * @type {Array<{input: Array<string>|null, parser: object, targets: Array<{formatter: object, contract: Contract, output: DirectoryObject}>}>}
+   */
+  #routes
+
+  /** The distinct contracts across each route's targets. @type {Map<object, Array<Contract>>} */
+  #contracts
+
   /** An instance of CLIOutput @type {CLIOutput} */
   #cli
 
-  /** @type {DirectoryObject} */
-  #output
+  /** The hook classes, as loaded from the hooks module. */
+  #hooks
 
-  /** @type {Contract} */
-  #contract
+  /** Milliseconds any one hook may take (see Hooks). */
+  #hookTimeout
+
+  /** This run's hook instances, shared by every file. @type {{Parse?: object, Format?: object}} */
+  #hookInstances = {}
+
+  /**
+   * This run's compiled parser and formatter pipelines (see PipelineCache).
+   *
+   * @type {{parse: PipelineCache, format: PipelineCache}|null}
+   */
+  #pipelines = null
 
-  #hooks
   #basePath
 
+  /** Number of worker threads to parse/format on; 0 keeps it all in-process. */
+  #workers
+
+  /** Module paths of the negotiated parsers, formatters and hooks. */
+  #modules
+
+  /** @type {WorkerPool|null} */
+  #pool = null
+
+  /** @type {BuildCache|null} */
+  #cache
+
+  /** @type {RunMetrics|null} */
+  #metrics = null
+
+  /** This run's output manifest. @type {OutputManifest|null} */
+  #manifest = null
+
+  /** Whether to leave byte-identical outputs unwritten (see OutputWriter). */
+  #skipUnchanged
+
+  /** The character encoding of input files (see SourceReader). */
+  #encoding
+
+  /** Whether to adapt the number of files in flight (see ConcurrencyController). */
+  #adaptive
+
+  /** Per-stage pool limits, as given; the rest are defaulted per run. */
+  #stageLimits
+
+  /**
+   * The run's stage pools: read (and cache lookup), parse, format and write.
+   *
+   * @type {{read: StagePool, parse: StagePool, format: StagePool, write: StagePool}|null}
+   */
+  #stages = null
+
   constructor({
     basePath,
-    parser,
-    formatter,
+    routes,
     hooks,
-    contract,
-    output,
-    cli
+    hookTimeout = 0,
+    cli,
+    workers = 0,
+    modules = {},
+    cache = null,
+    adaptive = false,
+    stages = {},
+    encoding = "utf8",
+    skipUnchanged = false,
   }) {
     this.#basePath = basePath
-    this.#parser = parser
-    this.#formatter = formatter
+    this.#routes = routes
+    this.#contracts = new Map(routes.map(route =>
+      [route, [...new Set(route.targets.map(target => target.contract))]]))
     this.#hooks = hooks
-    this.#contract = contract
-    this.#output = output
+    this.#hookTimeout = hookTimeout
     this.#cli = cli
+    this.#workers = workers
+    this.#modules = modules
+    this.#cache = cache
+    this.#adaptive = adaptive
+    this.#stageLimits = stages
+    this.#encoding = encoding
+    this.#skipUnchanged = skipUnchanged
+  }
+
+  /**
+   * The output file a formatter produces for an input file.
+   *
+   * @param {FileObject} file - The input file.
+   * @param {object} formatter - The formatter action class.
+   * @param {DirectoryObject} output - The output directory.
+   * @returns {FileObject} The output file.
+   */
+  static outputFor(file, formatter, output) {
+    const extension = formatter.meta.extension ?? "txt"
+
+    return new FileObject(`${file.module}.${extension}`, output)
+  }
+
+  /**
+   * The output files a route produces for an input file, one per target.
+   *
+   * @param {FileObject} file - The input file.
+   * @param {object} route - The file's route.
+   * @returns {Array<FileObject>} The output files.
+   */
+  static outputsFor(file, route) {
+    return route.targets.map(({formatter, output}) =>
+      Conveyor.outputFor(file, formatter, output))
+  }
+
+  /**
+   * The route an input file takes: the first whose globs (relative to the
+   * base path) match it, or the fallback route without globs.
+   *
+   * @param {FileObject} file - The input file.
+   * @param {Array<object>} routes - The routes, in order.
+   * @param {DirectoryObject} basePath - The base path globs are relative to.
+   * @returns {object|null} The route, or null if none matches.
+   */
+  static routeFor(file, routes, basePath) {
+    const relative = path.relative(basePath.path, file.path)
+
+    return routes.find(({input}) =>
+      !input || input.some(glob => path.matchesGlob(relative, glob))) ?? null
   }
 
   /**
-   * Emits a pipeline stage transition for a file.
+   * Emits a pipeline stage transition for a file. A file that fails ends
+   * with an `error` transition; one that completes ends with its
+   * `output-size` (see {@link Conveyor#emitSize}).
    *
    * @param {FileObject} file - The file the stage pertains to.
    * @param {string} stage - The stage name (read|parse|validate|format|write).
    * @param {string} state - The new state (active|done|warning|error).
+   * @param {string} [detail] - What went wrong, for warning and error states.
    */
-  #emitStage = (file, stage, state) =>
-    Notify.emit("update-data", {file, message: {kind: "stage", stage, state}})
+  #emitStage = (file, stage, state, detail) => {
+    const at = performance.now()
+    const message = {kind: "stage", stage, state, at}
+
+    if(detail !== undefined)
+      message.detail = detail
+
+    this.#metrics?.stage(file, stage, state, at)
+    Notify.emit("update-data", {file, message})
+  }
+
+  /**
+   * Emits an input or output size for a file.
+   *
+   * @param {FileObject} file - The file the size pertains to.
+   * @param {"input-size"|"output-size"} kind - Which size.
+   * @param {number} value - The size in bytes.
+   */
+  #emitSize = (file, kind, value) => {
+    this.#metrics?.size(file, kind, value)
+    Notify.emit("update-data", {file, message: {kind, value}})
+  }
 
   /**
    * Defines the per-file processing pipeline.
@@ -59,6 +208,7 @@ export default class Conveyor {
   setup(builder) {
     builder
       .do("read", this.#readFile)
+      .do("lookup", IF, () => this.#cache != null, this.#lookupCache)
       .do("parse", this.#parseFile)
       .do("validate", this.#validateContracts)
       .do("format", this.#formatFile)
@@ -67,90 +217,383 @@ export default class Conveyor {
 
   /**
    * Processes files through the parser→formatter pipeline with concurrency.
+   * Files of every route share the one pipeline and concurrency limit. Each
+   * file is read, parsed and validated once by its route's parser; its
+   * parse result is then formatted and written for every target of the
+   * route concurrently. Files no route matches are reported as errors.
+   *
+   * Files may be given as an array or as an (async) iterable such as an
+   * {@link InputSource}. They are pulled one at a time, only when there is
+   * room for another in flight, so processing starts while a large input set
+   * is still being enumerated and only files in flight are held in memory.
+   * Listeners hear `conveyor-start` once, then `conveyor-queue` with each
+   * file's context as it is taken on.
+   *
+   * How many files are in flight at once is decided by a
+   * {@link ConcurrencyController}: fixed at `maxConcurrent`, or, in adaptive
+   * mode, tuned while the run goes with `maxConcurrent` as the ceiling.
+   * Within that, each group of stages has its own {@link StagePool}: read,
+   * parse (with validate), format and write. A file takes a slot in a pool
+   * only for the length of its stages there, so I/O-bound and CPU-bound
+   * work overlap instead of one waiting on the other; and since files in
+   * flight are capped, so is what queues in front of each pool.
    *
-   * @param {Array<FileObject>} files - List of files to process.
+   * @param {Iterable<FileObject>|AsyncIterable<FileObject>} files - The files
+   *   to process.
    * @param {number} [maxConcurrent] - Maximum number of files to process at a time.
-   * @returns {Promise<object>} - Resolves with {succeeded, errored, warned}.
+   * @returns {Promise<object>} - Resolves with {succeeded, errored, warned},
+   *   `totalFiles` (every file taken, routed or not),
+   *   `metrics` (see RunMetrics#summary, plus the controller's summary as
+   *   `concurrency` and each pool's as `pools`), `manifest` (the run's
+   *   OutputManifest), and `cache` hit/partial/miss counts when the build
+   *   cache is enabled.
    */
   async convey(files, maxConcurrent = 10) {
     const builder = new ActionBuilder(this)
     const runner = new ActionRunner(builder)
-      .addSetup(async() => {
-        if(this.#output && !await this.#output.exists)
-          await this.#output.assureExists({recursive: true})
+
+    this.#metrics = new RunMetrics(performance.now())
+    this.#manifest = new OutputManifest()
+
+    Notify.emit("conveyor-start")
+
+    // The input set's size isn't known yet; workers are started regardless
+    // (and only as many as there are files, when given a list).
+    if(this.#workers > 0 && files.length !== 0)
+      this.#pool = new WorkerPool({
+        size: Math.min(this.#workers, files.length ?? this.#workers),
+        script: new URL("./ConveyorWorker.js", import.meta.url),
+        workerData: {modules: this.#modules, hookTimeout: this.#hookTimeout},
       })
+    else
+      this.#compilePipelines()
+
+    const controller = new ConcurrencyController({
+      max: maxConcurrent,
+      adaptive: this.#adaptive,
+    })
+
+    this.#stages = this.#createStages(maxConcurrent)
+
+    try {
+      await this.#prepareOutputs()
+
+      controller.start()
+
+      const result = await this.#schedule(runner, files, controller)
+
+      result.metrics = {
+        ...this.#metrics.summary(),
+        concurrency: controller.summary(),
+        pools: Object.fromEntries(Object.entries(this.#stages)
+          .map(([name, pool]) => [name, pool.summary()])),
+      }
+      result.manifest = this.#manifest
+
+      if(this.#cache) {
+        await this.#cache.save()
+        result.cache = this.#cache.stats
+      }
+
+      return result
+    } finally {
+      controller.stop()
+
+      await this.#pool?.close()
+      this.#pool = null
+      this.#stages = null
+      this.#hookInstances = {}
+      this.#pipelines = null
+    }
+  }
+
+  /**
+   * Instantiate this run's hooks and build every routed parser's and
+   * formatter's pipeline, once, for all files to share.
+   */
+  #compilePipelines() {
+    this.#hookInstances = Object.fromEntries(["Parse", "Format"]
+      .filter(kind => this.#hooks?.[kind])
+      .map(kind => [kind, Hooks.instantiate(this.#hooks[kind], this.#hookTimeout)]))
+
+    this.#pipelines = {
+      parse: new PipelineCache(this.#hookInstances.Parse)
+        .compile(this.#routes.map(route => route.parser)),
+      format: new PipelineCache(this.#hookInstances.Format)
+        .compile(this.#routes.flatMap(route => route.targets.map(target => target.formatter))),
+    }
+  }
+
+  /**
+   * Create the run's stage pools. Unless configured otherwise, the I/O
+   * pools (read, write) take up to `maxConcurrent` files. With worker
+   * threads, parse and format take one file per worker. On the main thread,
+   * format takes up to `maxConcurrent` too, as its hooks are often waiting
+   * on the network rather than working; parse takes half, as a synchronous
+   * parser gains nothing from more files in flight.
+   *
+   * @param {number} maxConcurrent - The in-flight ceiling.
+   * @returns {{read: StagePool, parse: StagePool, format: StagePool, write: StagePool}}
+   *   The pools.
+   */
+  #createStages(maxConcurrent) {
+    const threaded = this.#workers > 0
+    const defaults = {
+      read: maxConcurrent,
+      parse: threaded ? this.#workers : Math.ceil(maxConcurrent / 2),
+      format: threaded ? this.#workers : maxConcurrent,
+      write: maxConcurrent,
+    }
+
+    return Object.fromEntries(Object.entries(defaults).map(([name, limit]) =>
+      [name, new StagePool({name, limit: this.#stageLimits[name] ?? limit})]))
+  }
+
+  /** Create any output directories that don't exist yet. */
+  async #prepareOutputs() {
+    const outputs = new Set(this.#routes.flatMap(route =>
+      route.targets.map(target => target.output)))
+
+    for(const output of outputs) {
+      if(output && !await output.exists)
+        await output.assureExists({recursive: true})
+    }
+  }
+
+  /**
+   * The pipeline context of an input file, or null if no route takes it.
+   *
+   * @param {FileObject} file - The input file.
+   * @returns {object|null} The context.
+   */
+  #contextFor(file) {
+    const route = Conveyor.routeFor(file, this.#routes, this.#basePath)
 
-    const destExtension = this.#formatter.meta.extension ?? "txt"
-    const contexts = files.map(file => ({
-      file,
-      output: new FileObject(`${file.module}.${destExtension}`, this.#output)
-    }))
+    if(!route)
+      return null
 
-    Notify.emit("conveyor-start", contexts)
+    const outputs = Conveyor.outputsFor(file, route)
 
-    const settled = await runner.pipe(contexts, maxConcurrent)
+    // `output` is the first target's, for listeners that show just one.
+    return {file, route, output: outputs[0], outputs}
+  }
+
+  /**
+   * Runs every file through the pipeline, taking the next one whenever fewer
+   * than the controller's current limit are in flight. Each file's outcome
+   * is reduced to its result entry as soon as it settles, so finished
+   * contexts (and their content) are not kept.
+   *
+   * @param {ActionRunner} runner - The pipeline runner.
+   * @param {Iterable<FileObject>|AsyncIterable<FileObject>} files - The files.
+   * @param {ConcurrencyController} controller - Decides the in-flight limit.
+   * @returns {Promise<object>} {succeeded, errored, warned, totalFiles},
+   *   each list in input order.
+   */
+  async #schedule(runner, files, controller) {
+    const outcomes = []
+    const running = new Set()
+    let wake = null
 
-    return this.#categorize(settled, files)
+    // If enumeration fails, the files already taken on still finish
+    // before the error surfaces.
+    try {
+      for await(const file of files) {
+        const index = outcomes.length
+        const ctx = this.#contextFor(file)
+
+        outcomes.push(null)
+
+        if(!ctx) {
+          outcomes[index] = {kind: "errored", entry: {input: file, error: Sass.new(`No route matches ${file.path}`)}}
+          continue
+        }
+
+        while(running.size >= controller.limit)
+          await new Promise(resolve => (wake = resolve))
+
+        this.#metrics.queued(file, performance.now())
+        this.#manifest.expect(ctx.outputs)
+        Notify.emit("conveyor-queue", ctx)
+
+        const task = runner.run(ctx)
+          .then(
+            value => (outcomes[index] = Conveyor.#outcome(file, value)),
+            reason => (outcomes[index] = {kind: "errored", entry: {input: file, error: reason}}),
+          )
+          .finally(() => {
+            running.delete(task)
+            controller.complete()
+            wake?.()
+            wake = null
+          })
+
+        running.add(task)
+      }
+    } finally {
+      await Promise.allSettled(running)
+    }
+
+    const result = {succeeded: [], errored: [], warned: [], totalFiles: outcomes.length}
+
+    for(const {kind, entry} of outcomes)
+      result[kind].push(entry)
+
+    return result
+  }
+
+  /**
+   * Hands a CPU-bound task to the worker pool. The worker reports its own
+   * stage transitions, which are re-emitted here against the file so that
+   * listeners can't tell the difference from in-process work.
+   *
+   * @param {string} task - The worker task (parse|format).
+   * @param {object} ctx - The file context.
+   * @param {unknown} payload - The task input.
+   * @param {Array<ArrayBuffer>} [transfer] - Buffers to move, not copy, to
+   *   the worker.
+   * @returns {Promise<unknown>} The task's result.
+   */
+  #offload(task, ctx, payload, transfer) {
+    return this.#pool.run(task, payload,
+      ({stage, state}) => this.#emitStage(ctx.file, stage, state), transfer)
   }
 
   // -- Pipeline activities --------------------------------------------------
 
-  #readFile = async ctx => {
+  #readFile = ctx => this.#stages.read.run(async() => {
     try {
       this.#emitStage(ctx.file, "read", "active")
 
-      const content = await ctx.file.read()
+      // Streaming parsers pull lines themselves during parse; nothing is
+      // loaded here beyond the size.
+      if(SourceReader.wantsStream(ctx.route.parser)) {
+        const {size} = await fs.stat(ctx.file.path)
+
+        this.#emitSize(ctx.file, "input-size", size)
+        this.#emitStage(ctx.file, "read", "done")
+
+        return {...ctx, stream: true}
+      }
+
+      // The bytes are kept as they are; the parser decides whether, and it
+      // is decoded in the thread that parses (see SourceReader.input).
+      const buffer = await fs.readFile(ctx.file.path)
 
-      Notify.emit("update-data", {file: ctx.file, message: {kind: "input-size", value: Buffer.byteLength(content)}})
+      this.#emitSize(ctx.file, "input-size", buffer.length)
       this.#emitStage(ctx.file, "read", "done")
 
-      return {...ctx, content}
+      return {...ctx, buffer}
     } catch(error) {
-      this.#emitStage(ctx.file, "read", "error")
+      this.#emitStage(ctx.file, "read", "error", error.message)
 
       return {...ctx, status: "error", error: Sass.new(`Reading file ${ctx.file}`, error)}
     }
-  }
+  })
 
-  #parseFile = async ctx => {
+  /**
+   * Classifies the file against the build cache. A `hit` has nothing left to
+   * do; a `partial` carries its cached parse result straight to formatting.
+   *
+   * @param {object} ctx - The file context.
+   * @returns {Promise<object>} The context, annotated with `cache`.
+   */
+  #lookupCache = async ctx => {
     if(ctx.error)
       return ctx
 
-    try {
-      this.#emitStage(ctx.file, "parse", "active")
+    const {status, functions} = await this.#stages.read.run(() => this.#cache.lookup(ctx))
 
-      const {content} = ctx
-      const builder = new ActionBuilder(new this.#parser())
+    ctx.cache = status
+    Notify.emit("update-data", {file: ctx.file, message: {kind: "cache", value: status}})
 
-      if(this.#hooks?.Parse)
-        builder.withHooks(new this.#hooks.Parse())
+    if(status === "partial") {
+      this.#emitStage(ctx.file, "parse", "done")
+      this.#emitStage(ctx.file, "validate", "done")
 
-      const runner = new ActionRunner(builder)
-      const result = await runner.run(content)
+      return Object.assign(ctx, {functions})
+    }
 
-      this.#emitStage(ctx.file, "parse", "done")
+    if(status === "hit") {
+      for(const stage of ["parse", "validate", "format", "write"])
+        this.#emitStage(ctx.file, stage, "done")
+
+      const stats = await Promise.all(ctx.outputs.map(output => fs.stat(output.path)))
+
+      this.#emitSize(ctx.file, "output-size", stats.reduce((sum, {size}) => sum + size, 0))
+
+      return Object.assign(ctx, {status: "success"})
+    }
+
+    return ctx
+  }
+
+  #parseFile = async ctx => {
+    if(ctx.error || ctx.cache === "hit" || ctx.cache === "partial")
+      return ctx
 
-      return Object.assign(ctx, {...result})
+    try {
+      const {buffer, stream, file, route} = ctx
+      const encoding = this.#encoding
+      const result = await this.#stages.parse.run(() => this.#pool
+        ? this.#offload("parse", ctx, {
+          module: route.module,
+          encoding,
+          ...(stream ? {path: file.path} : {buffer}),
+        }, Conveyor.#transferable(buffer))
+        : this.#parse(route, file, stream
+          ? SourceReader.lines(file.path, {encoding})
+          : SourceReader.input(route.parser, buffer, encoding)))
+
+      // The source is not needed past parsing.
+      return Object.assign(ctx, {...result, buffer: undefined})
     } catch(error) {
-      this.#emitStage(ctx.file, "parse", "error")
+      this.#emitStage(ctx.file, "parse", "error", error.message)
 
       return {...ctx, status: "error", error: Sass.new(`Parsing file ${ctx.file}`, error)}
     }
   }
 
+  /**
+   * The buffers that can be moved to a worker rather than copied: a Buffer
+   * that has its memory to itself (not a slice of Node's shared pool).
+   *
+   * @param {Buffer} [buffer] - The file's bytes.
+   * @returns {Array<ArrayBuffer>} The transfer list.
+   */
+  static #transferable(buffer) {
+    return buffer && buffer.byteOffset === 0 &&
+      buffer.byteLength === buffer.buffer.byteLength
+      ? [buffer.buffer]
+      : []
+  }
+
+  #parse = async({parser}, file, input) => {
+    this.#emitStage(file, "parse", "active")
+
+    const result = await this.#pipelines.parse.runner(parser).run(input)
+
+    this.#emitStage(file, "parse", "done")
+
+    return result
+  }
+
+  // Validation is synchronous, so it cannot overlap anything anyway; it runs
+  // without re-queueing for a parse slot once parsing is done.
   #validateContracts = ctx => {
-    if(ctx.error)
+    if(ctx.error || ctx.cache === "hit" || ctx.cache === "partial")
       return ctx
 
     try {
       this.#emitStage(ctx.file, "validate", "active")
 
-      this.#contract.validate(ctx)
+      for(const contract of this.#contracts.get(ctx.route))
+        contract.validate(ctx)
 
       this.#emitStage(ctx.file, "validate", "done")
     } catch(err) {
       if(err) {
-        this.#emitStage(ctx.file, "validate", "error")
+        this.#emitStage(ctx.file, "validate", "error", err.message ?? String(err))
 
         throw Sass.new(`Parser validation for ${ctx.file.path}`, err)
       }
@@ -160,59 +603,103 @@ export default class Conveyor {
   }
 
   #formatFile = async ctx => {
-    if(ctx.error)
+    if(ctx.error || ctx.cache === "hit")
       return ctx
 
-    this.#emitStage(ctx.file, "format", "active")
-
     const {functions} = ctx
-    const builder = new ActionBuilder(new this.#formatter())
 
-    if(this.#hooks?.Format)
-      builder.withHooks(new this.#hooks.Format())
+    return this.#stages.format.run(async() => {
+      // One format stage spans every target, so it is reported here rather
+      // than by each formatter run (or worker).
+      this.#emitStage(ctx.file, "format", "active")
 
-    const runner = new ActionRunner(builder)
-    const formatResult = await runner.run(functions)
+      const formatResults = await Promise.all(ctx.route.targets.map(target =>
+        this.#pool
+          ? this.#pool.run("format", {module: target.module, functions})
+          : this.#format(target, functions)))
 
-    this.#emitStage(ctx.file, "format", "done")
+      this.#emitStage(ctx.file, "format", "done")
 
-    return Object.assign(ctx, {formatResult})
+      return Object.assign(ctx, {formatResults})
+    })
   }
 
+  #format = async({formatter}, functions) =>
+    await this.#pipelines.format.runner(formatter).run(functions)
+
   #shouldWrite = ctx => {
     if(ctx.error)
       return ctx
 
-    const result = this.#output != null && ctx?.formatResult
+    if(ctx.cache === "hit") {
+      ctx.route.targets.forEach(({output}, index) =>
+        output != null && this.#manifest.record(ctx.outputs[index], "unchanged"))
+
+      return false
+    }
+
+    const result = ctx.route.targets.some(({output}, index) =>
+      output != null && ctx?.formatResults?.[index])
 
     if(result)
       return result
 
-    Object.assign(ctx, {status: "warning", warning: `No output content for ${ctx.file.path}`})
+    const warning = `No output content for ${ctx.file.path}`
+
+    Object.assign(ctx, {status: "warning", warning})
 
-    Notify.emit("update-data", {file: ctx.file, message: {kind: "output-size", value: 0}})
-    this.#emitStage(ctx.file, "write", "warning")
+    this.#emitStage(ctx.file, "write", "warning", warning)
+    this.#emitSize(ctx.file, "output-size", 0)
 
     return false
   }
 
-  #writeOutput = async ctx => {
+  #writeOutput = ctx => {
     if(ctx.error)
       return ctx
 
+    return this.#stages.write.run(() => this.#write(ctx))
+  }
+
+  #write = async ctx => {
     try {
       this.#emitStage(ctx.file, "write", "active")
 
-      const {formatResult: content, output} = ctx
+      const {formatResults, outputs} = ctx
+      const skipUnchanged = this.#skipUnchanged
+      const written = await Promise.all(ctx.route.targets.map(({output}, index) =>
+        output != null && formatResults[index]
+          ? OutputWriter.write(outputs[index], formatResults[index], {skipUnchanged})
+          : null))
+
+      written.forEach((result, index) =>
+        result && this.#manifest.record(outputs[index], result.status))
 
-      await output.write(content)
+      const sizes = written.map(result => result?.size ?? 0)
+      const size = sizes.reduce((sum, bytes) => sum + bytes, 0)
+
+      // Chunked output can only be found to be empty once it has been drained.
+      const empty = outputs.filter((_, index) => sizes[index] === 0)
+
+      if(empty.length > 0) {
+        const warning = outputs.length > 1
+          ? `No output content for ${ctx.file.path} (${empty.map(output => output.path).join(", ")})`
+          : `No output content for ${ctx.file.path}`
+
+        this.#emitStage(ctx.file, "write", "warning", warning)
+        this.#emitSize(ctx.file, "output-size", size)
+
+        return {...ctx, status: "warning", warning}
+      }
+
+      await this.#cache?.record(ctx)
 
-      Notify.emit("update-data", {file: ctx.file, message: {kind: "output-size", value: Buffer.byteLength(content)}})
       this.#emitStage(ctx.file, "write", "done")
+      this.#emitSize(ctx.file, "output-size", size)
 
-      return {...ctx, status: "success", output}
+      return {...ctx, status: "success"}
     } catch(error) {
-      this.#emitStage(ctx.file, "write", "error")
+      this.#emitStage(ctx.file, "write", "error", error.message)
 
       return {...ctx, status: "error", error: Sass.new(`Writing file ${ctx.file}`, error)}
     }
@@ -220,37 +707,24 @@ export default class Conveyor {
 
   // -- Result categorization ------------------------------------------------
 
-  #categorize(settled, files) {
-    const succeeded = []
-    const warned = []
-    const errored = []
-
-    for(let i = 0; i < settled.length; i++) {
-      const entry = settled[i]
-      const file = files[i]
-
-      if(entry.status === "rejected") {
-        errored.push({input: file, error: entry.reason})
-        continue
-      }
-
-      const val = entry.value
-
-      switch(val?.status) {
-        case "success":
-          succeeded.push({input: file, output: val.output})
-          break
-        case "warning":
-          warned.push({input: file, warning: val.warning})
-          break
-        case "error":
-          errored.push({input: file, error: val.error})
-          break
-        default:
-          errored.push({input: file, error: new Error(`Unknown status: ${val?.status}`)})
-      }
+  /**
+   * The result entry for a file the pipeline finished with.
+   *
+   * @param {FileObject} file - The input file.
+   * @param {object} val - The pipeline's final context.
+   * @returns {{kind: "succeeded"|"warned"|"errored", entry: object}} Which
+   *   list the file goes in, and its entry.
+   */
+  static #outcome(file, val) {
+    switch(val?.status) {
+      case "success":
+        return {kind: "succeeded", entry: {input: file, output: val.output, outputs: val.outputs}}
+      case "warning":
+        return {kind: "warned", entry: {input: file, warning: val.warning}}
+      case "error":
+        return {kind: "errored", entry: {input: file, error: val.error}}
+      default:
+        return {kind: "errored", entry: {input: file, error: new Error(`Unknown status: ${val?.status}`)}}
     }
-
-    return {succeeded, errored, warned}
   }
 }
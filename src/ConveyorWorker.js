@@ -0,0 +1,88 @@
+import {Data} from "@gesslar/toolkit"
+import {pathToFileURL} from "node:url"
+import {parentPort, workerData} from "node:worker_threads"
+
+import Hooks from "./Hooks.js"
+import OutputWriter from "./OutputWriter.js"
+import PipelineCache from "./PipelineCache.js"
+import SourceReader from "./SourceReader.js"
+
+/**
+ * Worker thread entry for {@link WorkerPool}. Loads the negotiated parsers,
+ * formatters and hooks modules once, then runs `parse` and `format` tasks
+ * posted by the main thread, reporting stage transitions as it goes. Each
+ * task names the module of the parser or formatter to run. Hook instances
+ * and the parser and formatter pipelines (see PipelineCache) are built once
+ * and shared by every task on this thread.
+ */
+
+const load = async path => path
+  ? await import(pathToFileURL(path).href)
+  : null
+
+const {modules, hookTimeout} = workerData
+
+const loadActions = async paths => new Map(await Promise.all(
+  paths.map(async path => [path, (await load(path)).default])))
+
+const [Parsers, Formatters, hooksModule] = await Promise.all([
+  loadActions(modules.parsers),
+  loadActions(modules.formatters),
+  load(modules.hooks),
+])
+const hooks = {}
+
+if(Data.isType(hooksModule?.Parse, "Function"))
+  hooks.Parse = Hooks.instantiate(hooksModule.Parse, hookTimeout)
+
+if(Data.isType(hooksModule?.Format, "Function"))
+  hooks.Format = Hooks.instantiate(hooksModule.Format, hookTimeout)
+
+const pipelines = {
+  parse: new PipelineCache(hooks.Parse).compile(Parsers.values()),
+  format: new PipelineCache(hooks.Format).compile(Formatters.values()),
+}
+
+const tasks = {
+  parse: async({module, buffer, encoding, path}) => {
+    const Parser = Parsers.get(module)
+
+    // Streaming parsers get their lines read here, in the worker, so the
+    // source never crosses the thread boundary. Otherwise the bytes arrive
+    // undecoded and are decoded here, off the main thread.
+    const input = path
+      ? SourceReader.lines(path, {encoding})
+      : SourceReader.input(Parser, buffer, encoding)
+
+    return await pipelines.parse.runner(Parser).run(input)
+  },
+
+  format: async({module, functions}) => {
+    const Formatter = Formatters.get(module)
+
+    // Chunked output can't be posted back lazily, so it is joined here.
+    return await OutputWriter.collect(
+      await pipelines.format.runner(Formatter).run(functions))
+  },
+}
+
+parentPort.on("message", async({id, task, payload}) => {
+  const stage = state => parentPort.postMessage({id, type: "stage", stage: task, state})
+
+  try {
+    stage("active")
+
+    const value = await tasks[task](payload)
+
+    stage("done")
+    parentPort.postMessage({id, type: "result", value})
+  } catch(error) {
+    parentPort.postMessage({
+      id,
+      type: "error",
+      error: {message: error?.message ?? String(error), stack: error?.stack},
+    })
+  }
+})
+
+parentPort.postMessage({type: "ready"})
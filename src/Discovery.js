@@ -3,18 +3,26 @@ import {Collection, Data, DirectoryObject, FileObject, Promised, Sass} from "@ge
 import {execSync} from "child_process"
 
 import Action from "./Action.js"
+import DiscoveryIndex from "./DiscoveryIndex.js"
+import Logger from "./Logger.js"
 import {Schemer} from "@gesslar/negotiator/browser"
 
 /**
  * @import {Glog} from "@gesslar/toolkit"
  */
 
+/** The meta key each kind of action is chosen by. */
+const CRITERIA = Object.freeze({parser: "input", formatter: "format"})
+
 export default class Discovery {
   /** @type {Glog} */
   #glog
 
   #options
 
+  /** The discovery index in use during this discovery, if any. */
+  #index = null
+
   /**
    * Constructor for Discovery.
    *
@@ -30,43 +38,63 @@ export default class Discovery {
   /**
    * Discover actions from local or global node_modules
    *
-   * @param {object} [specific] Configuration options for action discovery
-   * @param {FileObject} [specific.formatter] Print-related configuration options
-   * @param {FileObject} [specific.parser] Parse-related configuration options
+   * @param {object} [specific] Configuration options for action discovery.
+   *   Several modules of a kind may be given (one per route or target); a
+   *   `null` among them keeps the discovered actions of that kind as well.
+   * @param {FileObject|Array<FileObject|null>} [specific.formatter] Print-related configuration options
+   * @param {FileObject|Array<FileObject|null>} [specific.parser] Parse-related configuration options
    * @param {Function} validateBeDocSchema - The validator function for BeDoc's action schema
+   * @param {{parser?: Array<string|null>, formatter?: Array<string|null>}} [wanted]
+   *   The languages and formats discovery is for. Discovered modules whose
+   *   static meta (see {@link Discovery.actionEntry}) shows they serve none
+   *   of them are not imported at all; a `null` among them means any.
    * @returns {Promise<object>} A map of discovered modules
    */
-  async discoverActions(specific = {}, validateBeDocSchema) {
+  async discoverActions(specific = {}, validateBeDocSchema, wanted = {}) {
     const glog = this.#glog
 
     glog.debug("Discovering actions", 2)
 
-    glog.debug("Specific modules provided: %o", 2, Object.values(specific).filter(Boolean).length)
+    // Computed arguments are wrapped in Logger.lazy; they are only evaluated
+    // if the message is emitted (see Logger.gate).
+    glog.debug("Specific modules provided: %o", 2, Logger.lazy(() => Object.values(specific).flat().filter(Boolean).length))
     glog.debug("Specific modules provided: %j", 4, specific)
 
+    // Discovery is needed for a kind unless every route (or target) names
+    // its own module.
+    const needed = Object.fromEntries(Action.actionTypes.map(kind =>
+      [kind, [specific[kind]].flat().some(file => file == null)]))
+
     const files = []
     const options = this.#options
+
+    this.#index = null
+
     const mock = options?.mock
       ? Data.isType(options.mock, "DirectoryObject")
         ? options.mock
         : new DirectoryObject(options.mock)
       : null
 
-    if(mock) {
+    if(!Object.values(needed).some(Boolean)) {
+      glog.debug("Every action is specified; skipping discovery", 2)
+    } else if(mock) {
       glog.debug("Discovering mock actions in %o", 2, mock.path)
 
       const {files: formatters} = await mock.glob("bedoc-*-formatter.js")
       const {files: parsers} = await mock.glob("bedoc-*-parser.js")
 
-      files.push(...formatters, ...parsers)
+      files.push(
+        ...formatters.map(file => ({file, hint: {kind: "formatter"}})),
+        ...parsers.map(file => ({file, hint: {kind: "parser"}})),
+      )
     } else {
       glog.debug("Mock path not set, discovering actions in node_modules", 2)
 
       glog.debug("Looking for actions in project's package.json", 2)
       if(options.project) {
         const exported = (options.project.actions || [])
-          .map(m => new FileObject(m, options.basePath))
-          .flat()
+          .map(entry => Discovery.actionEntry(entry, options.basePath))
 
         glog.debug("Found %o modules in project's package.json", 2, exported.length)
         glog.debug("Found modules in project's package.json: %o", 2, exported)
@@ -76,121 +104,234 @@ export default class Discovery {
         glog.debug("No modules found in project's package.json", 2)
       }
 
-      glog.debug("Looking for modules in node_modules (global and locally installed)", 2)
+      // The index is used whenever there is somewhere to keep it; it
+      // invalidates itself (see DiscoveryIndex), and --rebuildDiscovery
+      // ignores it.
+      const index = options.cacheDir
+        ? new DiscoveryIndex({
+          directory: Data.isType(options.cacheDir, "DirectoryObject")
+            ? options.cacheDir
+            : new DirectoryObject(options.cacheDir),
+          basePath: options.basePath,
+        })
+        : null
 
-      // `npm root -g` in particular is unreliable in Docker/CI/nvm/volta
-      // environments without a configured global prefix. Fall back to skipping
-      // any root that can't be resolved rather than aborting the whole run.
-      const npmRoot = cmd => {
-        try {
-          return execSync(cmd).toString().trim()
-        } catch {
-          glog.debug("`%o` failed; skipping", 2, cmd)
+      const indexed = index && !options.rebuildDiscovery
+        ? await index.load()
+        : null
 
-          return ""
-        }
+      if(indexed) {
+        glog.debug("Using discovery index with %o modules", 2, indexed.length)
+
+        files.push(...indexed.map(({path, meta}) => ({file: new FileObject(path), hint: meta})))
+      } else {
+        files.push(...await this.#scanNodeModules(index))
       }
 
-      const directories = [
-        npmRoot("npm root"),
-        npmRoot("npm root -g"),
-      ]
-        .filter(Boolean)
-        .map(d => new DirectoryObject(d))
+      this.#index = index
+    }
 
-      const nodeModulesDirs = await Data.asyncFilter(directories, d => d.exists)
+    glog.debug("Discovered %o modules", 2, files.length)
+    glog.debug("Discovered modules %o", 2, Logger.lazy(() => files.map(({file}) => file.path)))
+    glog.debug("Discovered modules %o", 3, files)
+
+    const worthLoading = files
+      .filter(({hint}) => Discovery.#worthLoading(hint, needed, wanted))
+      .map(({file}) => file)
 
-      glog.debug("Found %o directories to search for actions", 2, directories.length)
+    glog.debug("Loading %o of %o discovered modules", 2, worthLoading.length, files.length)
 
-      glog.debug("Directories to search for actions: %o", 4, directories)
+    const loaded = await this.#loadActionsAndContracts(worthLoading, specific)
 
-      for(const nodeModulesDir of nodeModulesDirs) {
-        const dirsToSearch = []
-        const {directories: moduleDirs} = await nodeModulesDir.read()
+    if(this.#index) {
+      await this.#index.setLoaded(Object.values(loaded).flat())
+      await this.#index.save()
+    }
 
-        glog.debug("Found %o directories in %o", 2, moduleDirs.length, nodeModulesDir.path)
+    for(const [kind, actions] of Object.entries(loaded)) {
+      glog.debug("%o %o", 4, kind, actions)
 
-        // Handle scoped packages (e.g., @bedoc/something)
-        const scopedDirs = moduleDirs.filter(d => d.name.startsWith("@"))
+      for(const {file, terms} of actions) {
 
-        dirsToSearch.push(...moduleDirs)
+        try {
+          const isValid = validateBeDocSchema(terms)
+          if(!isValid) {
+            const {errors} = validateBeDocSchema
+            const report = Schemer.reportValidationErrors(errors)
 
-        // If we find a scope (e.g., "@bedoc"), look inside it for bedoc modules
-        for(const scopedDir of scopedDirs) {
-          const {directories: scopedPackages} = await scopedDir.read()
+            throw Sass.new(report)
+          }
 
-          glog.debug("Found %o directories under scoped package %o", 2, directories.length, scopedDir.name)
-          glog.debug("Found directories under scoped package %o\n%o", 2, scopedDir.path, scopedPackages.map(d => d.path))
+        } catch(error) {
+          glog.error(error)
 
-          dirsToSearch.push(...scopedPackages)
+          throw Sass.new(`Validating schema for ${file.path}`, error)
         }
+      }
+    }
 
-        glog.debug("Found %o directories to search for actions", 2, dirsToSearch.length)
-        glog.debug("Found directories to search for actions: %o", 4, dirsToSearch)
+    return loaded
+  }
 
-        const visibleDirs = dirsToSearch.filter(d => !d.name.startsWith("."))
+  /**
+   * Read an entry of a `bedoc.actions` list (in a package's or the
+   * project's package.json). An entry is the module's path, relative to the
+   * package, or an object with that `path` and a copy of the static meta
+   * discovery selects by, e.g.
+   * `{path: "lua-parser.js", kind: "parser", input: "lua"}` or
+   * `{path: "md.js", kind: "formatter", format: "markdown"}`. The meta lets
+   * discovery pass over modules it does not need without importing them.
+   *
+   * @param {string|object} entry - The entry
+   * @param {DirectoryObject} directory - The directory paths are relative to
+   * @returns {{file: FileObject, hint: object|null}} The module and its meta,
+   *   if given
+   */
+  static actionEntry(entry, directory) {
+    if(Data.isType(entry, "String"))
+      return {file: new FileObject(entry, directory), hint: null}
 
-        for(const dir of visibleDirs) {
-          const packageJsonFile = new FileObject("package.json", dir)
+    const {path, ...hint} = entry
 
-          if(!await packageJsonFile.exists)
-            continue
+    return {file: new FileObject(path, directory), hint}
+  }
 
-          const packageJson = await packageJsonFile.loadData()
+  /**
+   * Whether a discovered module could be of use, judged from its static
+   * meta alone. Without meta (or with partial meta) a module is loaded to
+   * find out.
+   *
+   * @param {object|null} hint - The module's static meta, if known
+   * @param {object} needed - Per kind, whether discovery is needed
+   * @param {object} wanted - Per kind, the languages or formats wanted
+   * @returns {boolean} True if the module should be imported
+   */
+  static #worthLoading(hint, needed, wanted) {
+    const kind = hint?.kind
 
-          if(!packageJson.bedoc)
-            continue
+    if(!kind || !(kind in CRITERIA))
+      return true
 
-          const {actions} = packageJson.bedoc ?? null
+    if(!needed[kind])
+      return false
 
-          if(!actions || !Array.isArray(actions))
-            continue
+    const values = wanted[kind]
+    const value = hint[CRITERIA[kind]]
 
-          const moduleFileObjects = actions.map(f => new FileObject(f, dir))
-          const actionObjects = await Data.asyncFilter(
-            moduleFileObjects, f => f.exists)
+    if(!values || values.includes(null) || value === undefined)
+      return true
 
-          glog.debug("Discovered %o modules from package.json file: %o", 2,
-            actions.length,
-            packageJsonFile.path
-          )
+    return values.includes(value)
+  }
+
+  /**
+   * Walk the local and global node_modules trees for packages that declare
+   * bedoc actions in their package.json, recording what was searched and
+   * found in the discovery index, if there is one.
+   *
+   * @param {DiscoveryIndex|null} index - The index being rebuilt
+   * @returns {Promise<Array<{file: FileObject, hint: object|null}>>} The
+   *   action modules found, with any static meta their package declares
+   */
+  async #scanNodeModules(index) {
+    const glog = this.#glog
+    const found = []
 
-          glog.debug("Discovered from package.json files: %o", 3, actions)
+    glog.debug("Looking for modules in node_modules (global and locally installed)", 2)
 
-          files.push(...actionObjects)
-        }
+    // `npm root -g` in particular is unreliable in Docker/CI/nvm/volta
+    // environments without a configured global prefix. Fall back to skipping
+    // any root that can't be resolved rather than aborting the whole run.
+    const npmRoot = cmd => {
+      try {
+        return execSync(cmd).toString().trim()
+      } catch {
+        glog.debug("`%o` failed; skipping", 2, cmd)
+
+        return ""
       }
     }
 
-    glog.debug("Discovered %o modules", 2, files.length)
-    glog.debug("Discovered modules", 2, files.map(f => f.path))
-    glog.debug("Discovered modules %o", 3, files)
+    const directories = [
+      npmRoot("npm root"),
+      npmRoot("npm root -g"),
+    ]
+      .filter(Boolean)
+      .map(d => new DirectoryObject(d))
 
-    const loaded = await this.#loadActionsAndContracts(files, specific)
+    const nodeModulesDirs = await Data.asyncFilter(directories, d => d.exists)
 
-    for(const [kind, actions] of Object.entries(loaded)) {
-      glog.debug("%o %o", 4, kind, actions)
+    glog.debug("Found %o directories to search for actions", 2, directories.length)
 
-      for(const {file, terms} of actions) {
+    glog.debug("Directories to search for actions: %o", 4, directories)
 
-        try {
-          const isValid = validateBeDocSchema(terms)
-          if(!isValid) {
-            const {errors} = validateBeDocSchema
-            const report = Schemer.reportValidationErrors(errors)
+    for(const nodeModulesDir of nodeModulesDirs) {
+      await index?.addDirectory(nodeModulesDir)
 
-            throw Sass.new(report)
-          }
+      const dirsToSearch = []
+      const {directories: moduleDirs} = await nodeModulesDir.read()
 
-        } catch(error) {
-          glog.error(error)
+      glog.debug("Found %o directories in %o", 2, moduleDirs.length, nodeModulesDir.path)
 
-          throw Sass.new(`Validating schema for ${file.path}`, error)
-        }
+      // Handle scoped packages (e.g., @bedoc/something)
+      const scopedDirs = moduleDirs.filter(d => d.name.startsWith("@"))
+
+      dirsToSearch.push(...moduleDirs)
+
+      // If we find a scope (e.g., "@bedoc"), look inside it for bedoc modules
+      for(const scopedDir of scopedDirs) {
+        const {directories: scopedPackages} = await scopedDir.read()
+
+        glog.debug("Found %o directories under scoped package %o", 2, directories.length, scopedDir.name)
+        glog.debug("Found directories under scoped package %o\n%o", 2, scopedDir.path, Logger.lazy(() => scopedPackages.map(d => d.path)))
+
+        await index?.addDirectory(scopedDir)
+
+        dirsToSearch.push(...scopedPackages)
+      }
+
+      glog.debug("Found %o directories to search for actions", 2, dirsToSearch.length)
+      glog.debug("Found directories to search for actions: %o", 4, dirsToSearch)
+
+      const visibleDirs = dirsToSearch.filter(d => !d.name.startsWith("."))
+
+      for(const dir of visibleDirs) {
+        const packageJsonFile = new FileObject("package.json", dir)
+
+        if(!await packageJsonFile.exists)
+          continue
+
+        const packageJson = await packageJsonFile.loadData()
+
+        if(!packageJson.bedoc)
+          continue
+
+        const {actions} = packageJson.bedoc ?? null
+
+        if(!actions || !Array.isArray(actions))
+          continue
+
+        const entries = actions.map(entry => Discovery.actionEntry(entry, dir))
+        const actionObjects = await Data.asyncFilter(
+          entries, ({file}) => file.exists)
+
+        glog.debug("Discovered %o modules from package.json file: %o", 2,
+          actions.length,
+          packageJsonFile.path
+        )
+
+        glog.debug("Discovered from package.json files: %o", 3, actions)
+
+        if(actionObjects.length > 0)
+          await index?.addDirectory(dir)
+
+        actionObjects.forEach(({file, hint}) => index?.addAction(file, hint))
+
+        found.push(...actionObjects)
       }
     }
 
-    return loaded
+    return found
   }
 
   /**
@@ -198,7 +339,7 @@ export default class Discovery {
    * respective contracts.
    *
    * @param {Array<FileObject>} moduleFiles - The module file objects to process
-   * @param {{parser: FileObject, formatter: FileObject}} specificModules - The specific modules to load
+   * @param {{parser: FileObject|Array<FileObject|null>, formatter: FileObject|Array<FileObject|null>}} specificModules - The specific modules to load
    * @returns {Promise<object>} The discovered actions
    */
   async #loadActionsAndContracts(moduleFiles, specificModules) {
@@ -214,8 +355,8 @@ export default class Discovery {
     )
 
     // Tag the specific actions to load, so we can filter them later
-    for(const [type, file] of Object.entries(specificModules)) {
-      if(file) {
+    for(const [type, files] of Object.entries(specificModules)) {
+      for(const file of [files].flat().filter(Boolean)) {
         glog.debug("Tagging specific module `%o` as `%o`", 3, file.path, type)
         file.specificType = file.specificType || []
         file.specificType.push(type)
@@ -224,7 +365,7 @@ export default class Discovery {
 
     const toLoad = [
       ...moduleFiles,
-      ...Object.values(specificModules).filter(Boolean),
+      ...Object.values(specificModules).flat().filter(Boolean),
     ]
 
     glog.debug("Loading %o discovered modules", 2, toLoad.length)
@@ -240,9 +381,9 @@ export default class Discovery {
         if(!action.default?.meta)
           return null
 
-        const {terms: actionTerms} = action.default.meta
-
-        const terms = await Terms.parse(actionTerms, file.parent)
+        const {meta} = action.default
+        const terms = await this.#index?.terms(file, meta) ??
+          await Terms.parse(meta.terms, file.parent)
 
         return {file, action, terms}
       })
@@ -259,25 +400,32 @@ export default class Discovery {
     const filteredActions = []
 
     for(const actionType of Action.actionTypes) {
-      const moduleFile = specificModules[actionType]
+      const requested = [specificModules[actionType]].flat()
+      const moduleFiles = requested.filter(Boolean)
       const matchingActions = []
 
-      if(moduleFile) {
+      if(moduleFiles.length > 0) {
         glog.debug("Filtering actions for specific: %o", 2, actionType)
-        const found = loadedActions.find(
-          e => e.file.specificType?.includes(actionType) &&
-               e.action.default.meta.kind === actionType
-        )
 
-        if(!found)
-          throw Sass.new(`Could not find specific action: ${moduleFile.path}`)
+        for(const moduleFile of moduleFiles) {
+          const found = loadedActions.find(
+            e => e.file === moduleFile &&
+                 e.action.default.meta.kind === actionType
+          )
+
+          if(!found)
+            throw Sass.new(`Could not find specific action: ${moduleFile.path}`)
 
-        matchingActions.push(found)
-      } else {
-        glog.debug("No specific action required for %o", 2, actionType)
+          matchingActions.push(found)
+        }
+      }
+
+      if(moduleFiles.length === 0 || requested.includes(null)) {
+        glog.debug("Keeping discovered %o actions", 2, actionType)
 
         const found = loadedActions.filter(
-          e => e.action.default.meta.kind === actionType
+          e => e.action.default.meta.kind === actionType &&
+               !moduleFiles.includes(e.file)
         )
 
         matchingActions.push(...found)
@@ -328,12 +476,9 @@ export default class Discovery {
       glog.debug("Found %o %o actions", 2, total, actionType)
     }
 
-    const total = Object.keys(resultActions).reduce((acc, curr) => {
-      return acc + resultActions[curr].length
-    }, 0)
-
     glog.debug("Loaded %o action definitions from %o modules", 2,
-      total, moduleFiles.length
+      Logger.lazy(() => Object.values(resultActions).reduce((acc, curr) => acc + curr.length, 0)),
+      moduleFiles.length
     )
 
     return resultActions
@@ -362,8 +507,10 @@ export default class Discovery {
       // First let's check if we wanted something specific
       if(validatedConfig[config]) {
         glog.debug("Checking for specific %o action", 3, actionType)
+        const wanted = validatedConfig[config]
         const found = actions[actionType].find(
-          a => a.file.specificType?.includes(actionType)
+          a => a.file.specificType?.includes(actionType) &&
+               (!wanted.path || a.file.path === wanted.path)
         )
 
         if(found) {
@@ -420,12 +567,12 @@ export default class Discovery {
 
       if(Data.isType(requirement, "object")) {
         for(const [key, value] of Object.entries(requirement)) {
-          glog.debug("Checking object requirement %o", 4, {key, value})
+          glog.debug("Checking object requirement %o", 4, Logger.lazy(() => ({key, value})))
 
           if(toValidate.action.default.meta[key] !== value)
             return false
 
-          glog.debug("Requirement met: %o", 4, {key, value})
+          glog.debug("Requirement met: %o", 4, Logger.lazy(() => ({key, value})))
         }
       } else if(Data.isType(requirement, "string")) {
         glog.debug("Checking string requirement: %o", 4, requirement)
@@ -0,0 +1,242 @@
+import {Data, FileObject} from "@gesslar/toolkit"
+import fs from "node:fs/promises"
+import process from "node:process"
+
+import BuildCache from "./BuildCache.js"
+
+/**
+ * @import {DirectoryObject} from "@gesslar/toolkit"
+ */
+
+/** Bump when the persisted index shape changes. */
+const INDEX_VERSION = 2
+
+/**
+ * Persisted index of the bedoc-capable packages found under the local and
+ * global `node_modules` trees, so that a warm start neither spawns `npm root`
+ * nor walks every installed package.
+ *
+ * The index records each searched root and scope directory with its mtime,
+ * a hash of the project's lockfile, and every action module found together
+ * with its meta and its parsed contract terms. It is considered stale when
+ * the runtime (node binary, global prefix, project) differs, when any
+ * recorded directory has been modified or removed, or when the lockfile
+ * changed. Installing or removing a package touches the directory it lives
+ * in, which is what invalidates it. Terms are further keyed by their source
+ * (see {@link BuildCache.termsSource}), so an edited terms file is parsed
+ * afresh.
+ */
+export default class DiscoveryIndex {
+  /** @type {DirectoryObject} */
+  #directory
+
+  /** @type {DirectoryObject} */
+  #basePath
+
+  /** Directories searched while building, with their mtimes. */
+  #directories = []
+
+  /** Action modules found while building, keyed by path. */
+  #actions = {}
+
+  #dirty = false
+
+  /**
+   * Constructor for DiscoveryIndex.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {DirectoryObject} arg.directory - The cache directory
+   * @param {DirectoryObject} arg.basePath - The project base path
+   */
+  constructor({directory, basePath}) {
+    this.#directory = directory
+    this.#basePath = basePath
+  }
+
+  get #file() {
+    return new FileObject("discovery.json", this.#directory)
+  }
+
+  /**
+   * Load the index, returning its action entries if it is still valid.
+   * Otherwise the index starts empty, to be rebuilt.
+   *
+   * @returns {Promise<Array<{path: string, meta: object|null}>|null>} The
+   *   indexed actions, or null if there is no usable index
+   */
+  async load() {
+    const file = this.#file
+
+    this.#dirty = true
+
+    if(!await file.exists)
+      return null
+
+    let data
+
+    try {
+      data = await file.loadData()
+    } catch {
+      return null
+    }
+
+    if(data?.version !== INDEX_VERSION || data.key !== this.#key)
+      return null
+
+    if(data.lockfile !== await this.#lockfileHash())
+      return null
+
+    for(const {path, mtimeMs} of data.directories ?? []) {
+      if(await DiscoveryIndex.#mtime(path) !== mtimeMs)
+        return null
+    }
+
+    if(!Data.isPlainObject(data.actions))
+      return null
+
+    this.#directories = data.directories
+    this.#actions = data.actions
+    this.#dirty = false
+
+    return Object.entries(data.actions)
+      .map(([path, {meta}]) => ({path, meta}))
+  }
+
+  /**
+   * Record a directory that was searched while building the index.
+   *
+   * @param {DirectoryObject} directory - A node_modules root or scope
+   * @returns {Promise<void>}
+   */
+  async addDirectory(directory) {
+    const mtimeMs = await DiscoveryIndex.#mtime(directory.path)
+
+    if(mtimeMs !== null) {
+      this.#directories.push({path: directory.path, mtimeMs})
+      this.#dirty = true
+    }
+  }
+
+  /**
+   * Record an action module found while building the index.
+   *
+   * @param {FileObject} file - The action module
+   * @param {object|null} [meta] - Its static meta from package.json, if any;
+   *   replaced by the full meta if the module is loaded
+   */
+  addAction(file, meta = null) {
+    this.#actions[file.path] ??= {meta}
+    this.#dirty = true
+  }
+
+  /**
+   * The parsed contract terms recorded for an action, if its terms source
+   * is unchanged since.
+   *
+   * @param {FileObject} file - The action module
+   * @param {object} meta - The action's meta, as loaded
+   * @returns {Promise<object|null>} The terms, or null if there are none to
+   *   reuse
+   */
+  async terms(file, meta) {
+    const entry = this.#actions[file.path]
+
+    if(!entry?.terms)
+      return null
+
+    return entry.termsKey === await DiscoveryIndex.#termsKey(meta, file)
+      ? entry.terms
+      : null
+  }
+
+  /**
+   * Record the meta and parsed contract terms of actions once they have
+   * been loaded. Terms are kept only when they are plain data.
+   *
+   * @param {Array<{file: FileObject, action: object, terms: object}>} loaded
+   *   - Loaded actions
+   * @returns {Promise<void>}
+   */
+  async setLoaded(loaded) {
+    for(const {file, action, terms} of loaded) {
+      const entry = this.#actions[file.path]
+      const meta = action?.default?.meta
+
+      if(!entry || !meta)
+        continue
+
+      const termsKey = await DiscoveryIndex.#termsKey(meta, file)
+
+      if(entry.termsKey === termsKey)
+        continue
+
+      Object.assign(entry, {
+        meta: {...meta},
+        terms: Data.isPlainObject(terms) ? terms : null,
+        termsKey,
+      })
+
+      this.#dirty = true
+    }
+  }
+
+  /**
+   * Persist the index, if anything changed since it was loaded.
+   *
+   * @returns {Promise<void>}
+   */
+  async save() {
+    if(!this.#dirty)
+      return
+
+    await this.#directory.assureExists({recursive: true})
+    await this.#file.write(JSON.stringify({
+      version: INDEX_VERSION,
+      key: this.#key,
+      lockfile: await this.#lockfileHash(),
+      directories: this.#directories,
+      actions: this.#actions,
+    }))
+
+    this.#dirty = false
+  }
+
+  /**
+   * What the discovered roots depend on besides the filesystem: the node
+   * install (nvm/volta switches change the global root), any explicit
+   * global prefix, and the project itself.
+   *
+   * @returns {string} The runtime key
+   */
+  get #key() {
+    return BuildCache.hash(
+      process.execPath,
+      process.env.npm_config_prefix,
+      process.env.PREFIX,
+      this.#basePath?.path,
+    )
+  }
+
+  async #lockfileHash() {
+    for(const name of ["package-lock.json", "npm-shrinkwrap.json", "yarn.lock", "pnpm-lock.yaml"]) {
+      const lockfile = new FileObject(name, this.#basePath)
+
+      if(await lockfile.exists)
+        return BuildCache.hash(name, await lockfile.read())
+    }
+
+    return null
+  }
+
+  static async #termsKey(meta, file) {
+    return BuildCache.hash(await BuildCache.termsSource(meta, file.path))
+  }
+
+  static async #mtime(path) {
+    try {
+      return (await fs.stat(path)).mtimeMs
+    } catch {
+      return null
+    }
+  }
+}
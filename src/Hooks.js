@@ -0,0 +1,99 @@
+import {Sass} from "@gesslar/toolkit"
+
+/**
+ * Prepares hook instances for the pipeline.
+ *
+ * A hooks module's `Parse` and `Format` classes are instantiated once per
+ * run (per thread, with workers) and the one instance is handed to every
+ * file's parser or formatter, while several files are in flight. Hooks
+ * must therefore not keep per-file state on `this`; anything a file needs to
+ * carry from one hook to the next belongs in its context (see
+ * examples/hooks/lpc-markdown-hooks.js). The methods the pipeline calls
+ * (`before$…`/`after$…` activity hooks, `setup` and `cleanup`) are wrapped
+ * to enforce `hookTimeout`: a hook whose promise has not settled in time
+ * fails the file with a timeout error instead of stalling the pipeline.
+ * Helpers the hooks call themselves are left alone, so they count toward
+ * the calling hook's time. Synchronous hooks cannot be interrupted and run
+ * as they are.
+ *
+ * A module may also export a `Run` class, whose `after$run(result)` is
+ * called once when the whole run has finished, with the processFiles
+ * result. That is the place for slow side effects, such as uploads, that
+ * would otherwise hold up every file; it is not subject to `hookTimeout`.
+ * The result's `manifest` (see OutputManifest) tells it which outputs
+ * actually changed.
+ */
+export default class Hooks {
+  /**
+   * Instantiate a hook class and wrap its hook methods with a timeout.
+   *
+   * @param {Function} Hook - The hook class
+   * @param {number} [timeout] - Milliseconds each hook may take; none if
+   *   not positive
+   * @returns {object} The instance
+   */
+  static instantiate(Hook, timeout) {
+    const instance = new Hook()
+
+    if(!(timeout > 0))
+      return instance
+
+    for(const name of Hooks.#hookNames(instance)) {
+      const method = instance[name]
+
+      instance[name] = (...args) =>
+        Hooks.#within(method.apply(instance, args), timeout, `${Hook.name}.${name}`)
+    }
+
+    return instance
+  }
+
+  /**
+   * The names of an instance's hook methods, own (arrow-function fields)
+   * and inherited: those the pipeline calls, as opposed to helpers.
+   *
+   * @param {object} instance - The hook instance
+   * @returns {Set<string>} The hook method names
+   */
+  static #hookNames(instance) {
+    const names = new Set()
+
+    for(let proto = instance; proto && proto !== Object.prototype; proto = Object.getPrototypeOf(proto)) {
+      for(const name of Object.getOwnPropertyNames(proto)) {
+        if(Hooks.#isHook(name) && typeof instance[name] === "function")
+          names.add(name)
+      }
+    }
+
+    return names
+  }
+
+  static #isHook(name) {
+    return name.startsWith("before$") || name.startsWith("after$") ||
+      name === "setup" || name === "cleanup"
+  }
+
+  /**
+   * Settle with a hook's result, or reject once the timeout passes.
+   *
+   * @param {unknown} result - What the hook returned
+   * @param {number} timeout - Milliseconds to allow
+   * @param {string} name - The hook's name, for the error
+   * @returns {unknown} The result, or a promise of it
+   */
+  static #within(result, timeout, name) {
+    if(!(result instanceof Promise))
+      return result
+
+    let timer
+
+    const expired = new Promise((_, reject) => {
+      timer = setTimeout(
+        () => reject(Sass.new(`Hook ${name} timed out after ${timeout}ms`)),
+        timeout,
+      )
+    })
+
+    return Promise.race([result, expired]).finally(() => clearTimeout(timer))
+  }
+}
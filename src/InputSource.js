@@ -0,0 +1,185 @@
+import {FileObject} from "@gesslar/toolkit"
+import fs from "node:fs/promises"
+import path from "node:path"
+
+/**
+ * @import {DirectoryObject} from "@gesslar/toolkit"
+ */
+
+/**
+ * The configured input set: `input` glob patterns less `exclude` patterns,
+ * relative to the base path (or absolute).
+ *
+ * The set is never expanded up front. {@link InputSource#files} walks the
+ * patterns with `fs.glob`, applying the excludes as it goes (an excluded
+ * directory is not descended into), and yields each file as it is found, so
+ * the {@link Conveyor} can start on the first files while the rest of a large
+ * tree is still being enumerated.
+ *
+ * A sharded source (`shard: {index, count}`, 1-based) yields only its share
+ * of the files, so that several machines can split one build between them.
+ * The whole set is enumerated first and partitioned by size, largest file
+ * first onto the lightest shard so far, so that shards take about as long as
+ * each other even when a few files dwarf the rest. Files are ordered by
+ * their path relative to the base path, and ties are broken the same way,
+ * so every machine arrives at the same partition of the same tree.
+ */
+export default class InputSource {
+  /** @type {DirectoryObject} */
+  #basePath
+
+  /** @type {Array<string>} */
+  #patterns
+
+  /** @type {Array<string>} */
+  #exclude
+
+  /** @type {{index: number, count: number}|null} */
+  #shard
+
+  /** The partition, once worked out. @type {Promise<Array<Array<FileObject>>>|null} */
+  #partition = null
+
+  /**
+   * Constructor for InputSource.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {DirectoryObject} arg.basePath - The directory patterns are relative to
+   * @param {Array<string>} arg.patterns - The `input` glob patterns
+   * @param {Array<string>} [arg.exclude] - The `exclude` glob patterns
+   * @param {{index: number, count: number}} [arg.shard] - The shard to yield
+   */
+  constructor({basePath, patterns, exclude = [], shard = null}) {
+    this.#basePath = basePath
+    this.#patterns = patterns
+    this.#exclude = exclude
+    this.#shard = shard
+  }
+
+  /** The `input` glob patterns. */
+  get patterns() {
+    return this.#patterns
+  }
+
+  /** The `exclude` glob patterns. */
+  get exclude() {
+    return this.#exclude
+  }
+
+  /** The shard this source yields, if it is sharded. */
+  get shard() {
+    return this.#shard
+  }
+
+  /**
+   * Enumerate the input files: lazily, or this shard's share once the whole
+   * set has been partitioned.
+   *
+   * @yields {FileObject} Each matching file not excluded, once
+   */
+  async *files() {
+    if(this.#shard)
+      yield* (await this.partition())[this.#shard.index - 1]
+    else
+      yield* this.#glob()
+  }
+
+  /**
+   * Partition the input set between the shards. Worked out once per source;
+   * a sharded source is not meant to be watched.
+   *
+   * @returns {Promise<Array<Array<FileObject>>>} Each shard's files, in
+   *   path order
+   */
+  partition() {
+    return (this.#partition ??= this.#weigh(this.#shard?.count ?? 1))
+  }
+
+  async #weigh(count) {
+    const found = []
+
+    for await(const file of this.#glob())
+      found.push(file)
+
+    const files = await Promise.all(found.map(async file => ({
+      file,
+      key: this.#relative(file.path),
+      // Empty files still cost something to process.
+      weight: Math.max((await fs.stat(file.path)).size, 1),
+    })))
+    const byKey = (a, b) => a.key < b.key ? -1 : a.key > b.key ? 1 : 0
+    const shards = Array.from({length: count}, () => ({files: [], weight: 0}))
+
+    for(const item of files.toSorted((a, b) => b.weight - a.weight || byKey(a, b))) {
+      const lightest = shards.reduce((min, shard) => shard.weight < min.weight ? shard : min)
+
+      lightest.files.push(item)
+      lightest.weight += item.weight
+    }
+
+    return shards.map(shard => shard.files.toSorted(byKey).map(item => item.file))
+  }
+
+  async *#glob() {
+    const entries = fs.glob(this.#patterns, {
+      cwd: this.#basePath.path,
+      withFileTypes: true,
+      exclude: dirent => this.excluded(path.join(dirent.parentPath, dirent.name)),
+    })
+
+    for await(const dirent of entries) {
+      if(!dirent.isDirectory())
+        yield new FileObject(path.join(dirent.parentPath, dirent.name))
+    }
+  }
+
+  /**
+   * Iterating the source enumerates its files.
+   *
+   * @returns {AsyncGenerator<FileObject>} The files
+   */
+  [Symbol.asyncIterator]() {
+    return this.files()
+  }
+
+  /**
+   * Whether a path matches an `input` pattern and no `exclude` pattern.
+   *
+   * @param {string} file - The path, absolute or relative to the base path
+   * @returns {boolean} True if the path is an input
+   */
+  matches(file) {
+    return this.#match(file, this.#patterns) && !this.excluded(file)
+  }
+
+  /**
+   * Whether a path matches an `exclude` pattern.
+   *
+   * @param {string} file - The path, absolute or relative to the base path
+   * @returns {boolean} True if the path is excluded
+   */
+  excluded(file) {
+    return this.#exclude.length > 0 && this.#match(file, this.#exclude)
+  }
+
+  #match(file, patterns) {
+    const absolute = path.resolve(this.#basePath.path, file)
+    const posix = this.#relative(absolute)
+
+    return patterns.some(pattern => path.isAbsolute(pattern)
+      ? path.matchesGlob(absolute, pattern)
+      : path.matchesGlob(posix, pattern.replace(/^\.\//, "")))
+  }
+
+  /**
+   * A path relative to the base path, with forward slashes.
+   *
+   * @param {string} file - The path, absolute or relative to the base path
+   * @returns {string} The relative path
+   */
+  #relative(file) {
+    return path.relative(this.#basePath.path, path.resolve(this.#basePath.path, file))
+      .split(path.sep)
+      .join("/")
+  }
+}
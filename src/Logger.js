@@ -58,8 +58,29 @@ export const loggerColours = {
  * - warn: Warning information
  * - info: Informational information
  * - error: Error information
+ *
+ * A debug message at a level that is not emitted costs one comparison:
+ * nothing is formatted and no call site is captured. Any argument (or the
+ * message itself) may be wrapped in {@link Logger.lazy}, whose function is
+ * only called when the message is emitted, so expensive arguments (mapped
+ * arrays, whole configs) cost nothing either. Every other argument, plain
+ * functions and classes included, is logged as it is. {@link Logger.gate}
+ * puts the same in front of a Glog.
  */
 
+/** A log argument computed only when its message is emitted. */
+class Lazy {
+  #compute
+
+  constructor(compute) {
+    this.#compute = compute
+  }
+
+  get value() {
+    return this.#compute()
+  }
+}
+
 export default class Logger {
   #name = null
   #debugLevel = 0
@@ -120,6 +141,60 @@ export default class Logger {
     return `[${this.#name}] ${loggerColours[level]}${tag}${loggerColours.reset}: ${message}`
   }
 
+  /**
+   * Wrap a Glog so that its `debug` is gated and lazy like Logger's: a
+   * message above `debugLevel` returns after one comparison, and lazy
+   * arguments are only computed for messages that are emitted. Everything
+   * else is the Glog's own.
+   *
+   * @param {object} glog - The Glog to wrap
+   * @param {number} [debugLevel] - The most detailed level to emit
+   * @returns {object} The gated Glog
+   */
+  static gate(glog, debugLevel = 0) {
+    const debug = (message, level = 0, ...arg) => {
+      if(level > debugLevel)
+        return
+
+      glog.debug(Logger.resolve(message), level, ...arg.map(Logger.resolve))
+    }
+
+    return new Proxy(glog, {
+      get(target, property) {
+        if(property === "debug")
+          return debug
+
+        const value = Reflect.get(target, property)
+
+        return typeof value === "function" ? value.bind(target) : value
+      },
+    })
+  }
+
+  /**
+   * Mark a log argument to be computed only if its message is emitted.
+   *
+   * @example
+   * glog.debug("Modules %o", 2, Logger.lazy(() => files.map(f => f.path)))
+   *
+   * @param {Function} compute - Computes the argument
+   * @returns {Lazy} The lazy argument
+   */
+  static lazy(compute) {
+    return new Lazy(compute)
+  }
+
+  /**
+   * The value of a log argument: a lazy argument's computed value, or the
+   * argument itself, untouched.
+   *
+   * @param {unknown} arg - The argument
+   * @returns {unknown} Its value
+   */
+  static resolve(arg) {
+    return arg instanceof Lazy ? arg.value : arg
+  }
+
   lastStackLine(error = new Error(), stepsRemoved = 3) {
     const stack = ErrorStackParser.parse(error)
 
@@ -166,16 +241,23 @@ export default class Logger {
     return result
   }
 
-  newDebug(tag) {
-    return function(message, level, ...arg) {
-      tag = this.extractFileFunction(this.#debugLevel)
-      this.debug(`[${tag}] ${message}`, level, ...arg)
-    }.bind(this)
+  newDebug() {
+    return (message, level = 0, ...arg) => {
+      // The call site is only worth capturing for a message that is emitted.
+      if(level > (this.#debugLevel ?? 4))
+        return
+
+      const tag = this.extractFileFunction(this.#debugLevel)
+
+      this.debug(`[${tag}] ${Logger.resolve(message)}`, level, ...arg)
+    }
   }
 
   debug(message, level = 0, ...arg) {
-    if(level <= (this.debugLevel ?? 4))
-      console.debug(this.#compose("debug", message, level), ...arg)
+    if(level > (this.#debugLevel ?? 4))
+      return
+
+    console.debug(this.#compose("debug", Logger.resolve(message), level), ...arg.map(Logger.resolve))
   }
 
   warn(message, ...arg) {
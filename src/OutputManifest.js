@@ -0,0 +1,139 @@
+import {FileObject} from "@gesslar/toolkit"
+import fs from "node:fs/promises"
+import path from "node:path"
+
+/**
+ * @import {DirectoryObject} from "@gesslar/toolkit"
+ */
+
+/**
+ * What a run did to its outputs, for hooks and downstream syncing to act on
+ * only what changed.
+ *
+ * Every output written is recorded as `created` (there was no such file),
+ * `updated` (its content differed) or `unchanged` (byte-identical, or left
+ * alone on a build cache hit); see {@link OutputWriter}. After a run over the
+ * whole input set, the output directories are also searched for `orphaned`
+ * outputs: files with a formatter's extension that no input maps to any more,
+ * typically left behind by a deleted or renamed source. Orphans are only
+ * reported, never removed.
+ */
+export default class OutputManifest {
+  /** Output path to its entry. @type {Map<string, {output: FileObject, status: string}>} */
+  #entries = new Map()
+
+  /** Paths of every output some input of the run maps to. @type {Set<string>} */
+  #expected = new Set()
+
+  /** @type {Array<FileObject>} */
+  #orphaned = []
+
+  /**
+   * Note the outputs an input maps to, whether or not they get written.
+   *
+   * @param {Array<FileObject>} outputs - The input's outputs
+   */
+  expect(outputs) {
+    for(const output of outputs)
+      this.#expected.add(output.path)
+  }
+
+  /**
+   * Record what happened to an output.
+   *
+   * @param {FileObject} output - The output
+   * @param {"created"|"updated"|"unchanged"} status - What happened to it
+   */
+  record(output, status) {
+    this.#entries.set(output.path, {output, status})
+  }
+
+  /**
+   * Find the outputs in the targets' directories that no input of the run
+   * maps to. Only meaningful after a run over the whole input set.
+   *
+   * @param {Array<{formatter: object, output: DirectoryObject|null}>} targets -
+   *   The routes' targets
+   * @returns {Promise<Array<FileObject>>} The orphaned outputs
+   */
+  async findOrphans(targets) {
+    const extensions = new Map()
+
+    for(const {formatter, output} of targets) {
+      if(!output)
+        continue
+
+      const known = extensions.get(output.path) ?? {directory: output, extensions: new Set()}
+
+      known.extensions.add(`.${formatter.meta.extension ?? "txt"}`)
+      extensions.set(output.path, known)
+    }
+
+    const orphaned = []
+
+    for(const {directory, extensions: wanted} of extensions.values()) {
+      let entries
+
+      try {
+        entries = await fs.readdir(directory.path, {withFileTypes: true})
+      } catch(error) {
+        if(error.code === "ENOENT")
+          continue
+
+        throw error
+      }
+
+      for(const entry of entries) {
+        const file = path.join(directory.path, entry.name)
+
+        if(entry.isFile() && wanted.has(path.extname(entry.name)) && !this.#expected.has(file))
+          orphaned.push(new FileObject(entry.name, directory))
+      }
+    }
+
+    return (this.#orphaned = orphaned)
+  }
+
+  /**
+   * The outputs by what happened to them.
+   *
+   * @returns {{created: Array<FileObject>, updated: Array<FileObject>, unchanged: Array<FileObject>, orphaned: Array<FileObject>}}
+   *   The manifest
+   */
+  summary() {
+    const summary = {created: [], updated: [], unchanged: [], orphaned: [...this.#orphaned]}
+
+    for(const {output, status} of this.#entries.values())
+      summary[status].push(output)
+
+    return summary
+  }
+
+  /**
+   * Write a manifest summary as JSON, with paths relative to the base path
+   * (and, for a sharded run, the shard it covers; see ShardMerge).
+   *
+   * @param {object} summary - The summary (see OutputManifest#summary)
+   * @param {object} arg - Where to write it
+   * @param {string} arg.destination - The file, relative to the base path
+   * @param {DirectoryObject} arg.basePath - The base path
+   * @param {{index: number, count: number}} [arg.shard] - The run's shard
+   * @returns {Promise<void>}
+   */
+  static async save(summary, {destination, basePath, shard}) {
+    const relative = files => files
+      .map(file => path.relative(basePath.path, file.path))
+      .toSorted()
+
+    const manifest = Object.fromEntries(Object.entries(summary)
+      .map(([status, files]) => [status, relative(files)]))
+
+    if(shard)
+      manifest.shard = shard
+
+    await fs.writeFile(
+      path.resolve(basePath.path, destination),
+      `${JSON.stringify(manifest, null, 2)}\n`,
+    )
+  }
+}
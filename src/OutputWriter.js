@@ -0,0 +1,195 @@
+import crypto from "node:crypto"
+import fs from "node:fs"
+import process from "node:process"
+import {pipeline} from "node:stream/promises"
+
+/**
+ * @import {FileObject} from "@gesslar/toolkit"
+ */
+
+/**
+ * Writes formatter output to disk.
+ *
+ * A formatter may return its output as a single string (or Buffer), or as
+ * chunks from a generator (sync or async) or other async iterable —
+ * typically an async generator yielding one section at a time. Chunked
+ * output is piped straight into a file write stream, so only the chunk in
+ * flight is ever held in memory, and its size is counted as it goes rather
+ * than measured afterwards. Anything else, arrays included, is one value
+ * and written as its string.
+ *
+ * Each write is compared with the output already on disk, by size and then
+ * by SHA-256 hash, and reported as `created`, `updated` or `unchanged` (see
+ * {@link OutputManifest}). With `skipUnchanged`, an identical output is not
+ * rewritten at all, so its mtime stays put for rsync and the like. Chunked
+ * output always goes to a temporary file alongside the destination first,
+ * and is renamed into place only once complete, and then only when it
+ * differs (or is always to be rewritten); a formatter that fails midway
+ * leaves no partial output behind.
+ */
+export default class OutputWriter {
+  /**
+   * Whether formatter output is chunked rather than a single value: an
+   * async iterable, or a sync iterator such as a generator. Plain iterables
+   * (strings, Buffers, arrays) are single values.
+   *
+   * @param {unknown} content - The formatter's result
+   * @returns {boolean} True if the content should be streamed
+   */
+  static isChunked(content) {
+    if(content == null || typeof content !== "object")
+      return false
+
+    if(typeof content[Symbol.asyncIterator] === "function")
+      return true
+
+    return typeof content[Symbol.iterator] === "function" &&
+      typeof content.next === "function"
+  }
+
+  /**
+   * Collects chunked output into a single string. Used where the output has
+   * to cross a thread boundary and can't stay lazy.
+   *
+   * @param {unknown} content - The formatter's result
+   * @returns {Promise<unknown>} The joined string, or the content unchanged
+   */
+  static async collect(content) {
+    if(!OutputWriter.isChunked(content))
+      return content
+
+    const parts = []
+
+    for await(const chunk of content)
+      parts.push(String(chunk))
+
+    return parts.join("")
+  }
+
+  /**
+   * Write formatter output to a file.
+   *
+   * @param {FileObject} output - The destination
+   * @param {unknown} content - A string or an iterable of chunks
+   * @param {object} [options] - Options
+   * @param {boolean} [options.skipUnchanged] - Leave an identical output as
+   *   it is rather than rewriting it
+   * @returns {Promise<{size: number, status: "created"|"updated"|"unchanged"}|null>}
+   *   The output's size in bytes and how it compares to what was there, or
+   *   null if the content was empty, in which case nothing is written and
+   *   any previous output is left as it was
+   */
+  static async write(output, content, {skipUnchanged = false} = {}) {
+    const existing = await OutputWriter.#sizeOf(output.path)
+
+    if(!OutputWriter.isChunked(content)) {
+      // Encode once; the encoded length is the size written.
+      const buffer = Buffer.isBuffer(content) ? content : Buffer.from(String(content))
+      const size = buffer.length
+
+      if(size === 0)
+        return null
+
+      const status = existing === null
+        ? "created"
+        : existing === size && await OutputWriter.#hashFile(output.path) === OutputWriter.#hash(buffer)
+          ? "unchanged"
+          : "updated"
+
+      if(status !== "unchanged" || !skipUnchanged)
+        await fs.promises.writeFile(output.path, buffer)
+
+      return {size, status}
+    }
+
+    const temporary = `${output.path}.${process.pid}.tmp`
+
+    try {
+      const hash = crypto.createHash("sha256")
+      const size = await OutputWriter.#stream(content, temporary, hash)
+
+      // Chunked output can only be found to be empty once drained.
+      if(size === 0) {
+        await fs.promises.rm(temporary)
+
+        return null
+      }
+
+      const status = existing === null
+        ? "created"
+        : existing === size && await OutputWriter.#hashFile(output.path) === hash.digest("hex")
+          ? "unchanged"
+          : "updated"
+
+      if(status === "unchanged" && skipUnchanged)
+        await fs.promises.rm(temporary)
+      else
+        await fs.promises.rename(temporary, output.path)
+
+      return {size, status}
+    } catch(error) {
+      await fs.promises.rm(temporary, {force: true})
+
+      throw error
+    }
+  }
+
+  /**
+   * Pipe chunked content into a file.
+   *
+   * @param {AsyncIterable|Iterator} content - The chunks
+   * @param {string} path - The file to write
+   * @param {crypto.Hash} [hash] - A hash to feed the bytes to as well
+   * @returns {Promise<number>} The number of bytes written
+   */
+  static async #stream(content, path, hash) {
+    let bytes = 0
+
+    await pipeline(
+      async function*() {
+        for await(const chunk of content) {
+          const buffer = Buffer.isBuffer(chunk) ? chunk : Buffer.from(String(chunk))
+
+          bytes += buffer.length
+          hash?.update(buffer)
+
+          yield buffer
+        }
+      },
+      fs.createWriteStream(path)
+    )
+
+    return bytes
+  }
+
+  /**
+   * The size of an existing file.
+   *
+   * @param {string} path - The file
+   * @returns {Promise<number|null>} Its size in bytes, or null if there is
+   *   no such file
+   */
+  static async #sizeOf(path) {
+    try {
+      return (await fs.promises.stat(path)).size
+    } catch(error) {
+      if(error.code === "ENOENT")
+        return null
+
+      throw error
+    }
+  }
+
+  static #hash(buffer) {
+    return crypto.createHash("sha256").update(buffer).digest("hex")
+  }
+
+  static async #hashFile(path) {
+    const hash = crypto.createHash("sha256")
+
+    for await(const chunk of fs.createReadStream(path))
+      hash.update(chunk)
+
+    return hash.digest("hex")
+  }
+}
@@ -0,0 +1,76 @@
+import {ActionBuilder, ActionRunner} from "@gesslar/actioneer"
+
+/**
+ * Builds each parser's or formatter's action pipeline once per run.
+ *
+ * Constructing the action, running its `setup` (with any nested SPLIT
+ * builders), attaching hooks and wrapping it all in an ActionRunner costs
+ * far more than most small files take to process. Here that is done the
+ * first time an action is asked for, and the same runner is then invoked
+ * for every file, with nothing but that file's context being new.
+ *
+ * Sharing a runner means files run through the same action instance, at
+ * the same time. An action that keeps per-file state on `this` declares
+ * `reentrant: false` in its `meta` and gets a freshly built pipeline per
+ * file instead.
+ */
+export default class PipelineCache {
+  /** The hook instance to attach to every pipeline, if any. */
+  #hooks
+
+  /** Runners keyed by action class. @type {Map<Function, ActionRunner>} */
+  #runners = new Map()
+
+  /**
+   * Constructor for PipelineCache.
+   *
+   * @param {object} [hooks] - The hook instance to attach (see Hooks)
+   */
+  constructor(hooks) {
+    this.#hooks = hooks
+  }
+
+  /**
+   * Build the pipelines of the given actions now, so that a broken setup
+   * fails the run before any file is processed.
+   *
+   * @param {Iterable<Function>} actions - Action classes
+   * @returns {PipelineCache} This object for chaining
+   */
+  compile(actions) {
+    for(const action of actions)
+      this.runner(action)
+
+    return this
+  }
+
+  /**
+   * The runner for an action: the compiled one, or a fresh one for an action
+   * that is not reentrant.
+   *
+   * @param {Function} action - The action class
+   * @returns {ActionRunner} The runner
+   */
+  runner(action) {
+    if(action.meta?.reentrant === false)
+      return this.#build(action)
+
+    let runner = this.#runners.get(action)
+
+    if(!runner) {
+      runner = this.#build(action)
+      this.#runners.set(action, runner)
+    }
+
+    return runner
+  }
+
+  #build(action) {
+    const builder = new ActionBuilder(new action())
+
+    if(this.#hooks)
+      builder.withHooks(this.#hooks)
+
+    return new ActionRunner(builder)
+  }
+}
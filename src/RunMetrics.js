@@ -0,0 +1,188 @@
+/**
+ * @import {FileObject} from "@gesslar/toolkit"
+ */
+
+/**
+ * Collects timing and size measurements for one Conveyor run.
+ *
+ * Conveyor feeds it every stage transition (stamped with a high-resolution
+ * time) and every size report. From those it derives, per file, how long
+ * each stage took, how long the file waited for a slot before its first
+ * stage (from when it was queued, or else from the start of the run), and
+ * its bytes in and out; and, across the run, a latency summary
+ * (count, total, p50, p95, max) per stage and for queue wait.
+ */
+export default class RunMetrics {
+  /** When the run was queued, in performance.now() milliseconds. */
+  #queuedAt
+
+  /** Per-file measurements keyed by file. @type {Map<FileObject, object>} */
+  #files = new Map()
+
+  /**
+   * Constructor for RunMetrics.
+   *
+   * @param {number} queuedAt - performance.now() when the run started
+   */
+  constructor(queuedAt) {
+    this.#queuedAt = queuedAt
+  }
+
+  #entry(file) {
+    let entry = this.#files.get(file)
+
+    if(!entry) {
+      entry = {queued: null, started: null, open: {}, stages: {}, bytesIn: null, bytesOut: null}
+      this.#files.set(file, entry)
+    }
+
+    return entry
+  }
+
+  /**
+   * Record when a file was queued, i.e. taken on while the input set was
+   * still being enumerated.
+   *
+   * @param {FileObject} file - The file
+   * @param {number} at - performance.now() when it was queued
+   */
+  queued(file, at) {
+    this.#entry(file).queued = at
+  }
+
+  /**
+   * Record a stage transition.
+   *
+   * @param {FileObject} file - The file
+   * @param {string} stage - The stage name
+   * @param {string} state - active|done|warning|error
+   * @param {number} at - performance.now() of the transition
+   */
+  stage(file, stage, state, at) {
+    const entry = this.#entry(file)
+
+    if(state === "active") {
+      entry.started ??= at
+      entry.open[stage] = at
+
+      return
+    }
+
+    const opened = entry.open[stage]
+
+    if(opened === undefined)
+      return
+
+    entry.stages[stage] = (entry.stages[stage] ?? 0) + (at - opened)
+    delete entry.open[stage]
+  }
+
+  /**
+   * Record a size report.
+   *
+   * @param {FileObject} file - The file
+   * @param {"input-size"|"output-size"} kind - Which size
+   * @param {number} value - Size in bytes
+   */
+  size(file, kind, value) {
+    const entry = this.#entry(file)
+
+    if(kind === "input-size")
+      entry.bytesIn = value
+    else
+      entry.bytesOut = value
+  }
+
+  /**
+   * Summarise the run.
+   *
+   * @returns {{files: Array<object>, stages: object, queueWait: object, bytesIn: number, bytesOut: number}}
+   *   Per-file measurements and aggregate latency summaries (milliseconds)
+   */
+  summary() {
+    const files = []
+    const perStage = {}
+    const waits = []
+    let bytesIn = 0
+    let bytesOut = 0
+
+    for(const [file, entry] of this.#files) {
+      const measured = this.#measure(file, entry)
+
+      if(measured.queueWaitMs !== null)
+        waits.push(measured.queueWaitMs)
+
+      for(const [stage, duration] of Object.entries(entry.stages)) {
+        perStage[stage] ??= []
+        perStage[stage].push(duration)
+      }
+
+      bytesIn += entry.bytesIn ?? 0
+      bytesOut += entry.bytesOut ?? 0
+
+      files.push(measured)
+    }
+
+    return {
+      files,
+      stages: Object.fromEntries(
+        Object.entries(perStage).map(([stage, samples]) => [stage, RunMetrics.histogram(samples)])
+      ),
+      queueWait: RunMetrics.histogram(waits),
+      bytesIn,
+      bytesOut,
+    }
+  }
+
+  /**
+   * The measurements taken so far for one file.
+   *
+   * @param {FileObject} file - The file
+   * @returns {{input: string, queueWaitMs: number|null, stages: object, bytesIn: number|null, bytesOut: number|null}}
+   *   Its queue wait, completed stage durations (milliseconds) and sizes
+   */
+  file(file) {
+    return this.#measure(file, this.#entry(file))
+  }
+
+  #measure(file, entry) {
+    return {
+      input: file.path,
+      queueWaitMs: entry.started === null
+        ? null
+        : RunMetrics.#round(entry.started - (entry.queued ?? this.#queuedAt)),
+      stages: Object.fromEntries(
+        Object.entries(entry.stages).map(([stage, duration]) => [stage, RunMetrics.#round(duration)])
+      ),
+      bytesIn: entry.bytesIn,
+      bytesOut: entry.bytesOut,
+    }
+  }
+
+  /**
+   * Latency summary of a set of samples (nearest-rank percentiles).
+   *
+   * @param {Array<number>} samples - Durations in milliseconds
+   * @returns {{count: number, totalMs?: number, p50Ms?: number, p95Ms?: number, maxMs?: number}}
+   *   The summary
+   */
+  static histogram(samples) {
+    if(samples.length === 0)
+      return {count: 0}
+
+    const sorted = samples.toSorted((a, b) => a - b)
+    const at = p => sorted[Math.max(0, Math.ceil(p * sorted.length) - 1)]
+
+    return {
+      count: sorted.length,
+      totalMs: RunMetrics.#round(sorted.reduce((a, b) => a + b, 0)),
+      p50Ms: RunMetrics.#round(at(0.5)),
+      p95Ms: RunMetrics.#round(at(0.95)),
+      maxMs: RunMetrics.#round(sorted.at(-1)),
+    }
+  }
+
+  static #round(n) {
+    return Math.round(n * 1000) / 1000
+  }
+}
@@ -0,0 +1,325 @@
+import {FileSystem as FS, Notify, Sass} from "@gesslar/toolkit"
+import fs from "node:fs/promises"
+import path from "node:path"
+import {performance} from "node:perf_hooks"
+import process from "node:process"
+
+import RunMetrics from "./RunMetrics.js"
+
+/**
+ * @import {DirectoryObject, FileObject} from "@gesslar/toolkit"
+ */
+
+/**
+ * Writes a machine-readable report of each run, built from the same
+ * `conveyor-start`, `conveyor-queue` and `update-data` events that drive
+ * {@link CLIOutput}.
+ *
+ * Two formats are produced, chosen by the destination's extension:
+ *
+ * - NDJSON (the default, and always for `-`, i.e. stdout) is streamed: a
+ *   `start` record when the conveyor starts, a `file` record
+ *   the moment each file finishes, and an `end` record with the totals.
+ * - JSON (a destination ending in `.json`) is one compact object,
+ *   `{start, files, end}`, written when the run ends.
+ *
+ * A `file` record carries the input path and its `outputs` (one per target;
+ * paths relative to the base path), `status` (success|warning|error), `cache` (hit|partial|miss, when
+ * the build cache is on), `queueWaitMs`, per-stage `stages` durations in
+ * milliseconds, `bytesIn`/`bytesOut`, and `warning` or `error` details.
+ * The `end` record carries the run's duration, counts, cache statistics and
+ * per-stage latency summaries (see {@link RunMetrics.histogram}).
+ *
+ * A sharded run's `start` record also carries its `shard` (`{index,
+ * count}`), which ShardMerge uses to check a set of reports is complete.
+ *
+ * In watch mode each run appends its own start…end sequence to an NDJSON
+ * report; a JSON report is rewritten with the latest run.
+ */
+export default class RunReport {
+  /** Absolute path of the report, or `-` for stdout. */
+  #destination
+
+  /** "ndjson" or "json". */
+  #format
+
+  /** The run's shard, if sharded. @type {{index: number, count: number}|null} */
+  #shard
+
+  /** @type {DirectoryObject} */
+  #basePath
+
+  /** Open handle on an NDJSON report file, between start and end. */
+  #handle = null
+
+  /** Whether a report file has been written before (then appended to). */
+  #written = false
+
+  /** Writes are chained so records land in order. */
+  #pending = Promise.resolve()
+
+  /** The first write failure, held for end() to throw. */
+  #error = null
+
+  /** @type {RunMetrics|null} */
+  #metrics = null
+
+  /** Per-file status keyed by file. @type {Map<FileObject, object>} */
+  #files = new Map()
+
+  /** The current run's records, for the JSON format. */
+  #run = null
+
+  /**
+   * Constructor for RunReport. Starts listening for conveyor events
+   * immediately, until {@link RunReport#dispose}.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {string} arg.destination - Report path (relative to basePath), or
+   *   `-` for stdout
+   * @param {DirectoryObject} arg.basePath - The project base path
+   * @param {{index: number, count: number}} [arg.shard] - The run's shard
+   */
+  constructor({destination, basePath, shard = null}) {
+    this.#basePath = basePath
+    this.#shard = shard
+    this.#destination = destination === "-"
+      ? destination
+      : path.resolve(basePath.path, destination)
+    this.#format = RunReport.formatFor(destination)
+
+    Notify.on("conveyor-start", this.#conveyorStart)
+    Notify.on("conveyor-queue", this.#conveyorQueue)
+    Notify.on("update-data", this.#updateData)
+  }
+
+  /**
+   * Stop listening for conveyor events. The report writes nothing further.
+   */
+  dispose() {
+    Notify.off("conveyor-start", this.#conveyorStart)
+    Notify.off("conveyor-queue", this.#conveyorQueue)
+    Notify.off("update-data", this.#updateData)
+  }
+
+  /**
+   * The report format a destination implies.
+   *
+   * @param {string} destination - Report path, or `-`
+   * @returns {"ndjson"|"json"} The format
+   */
+  static formatFor(destination) {
+    return path.extname(destination).toLowerCase() === ".json"
+      ? "json"
+      : "ndjson"
+  }
+
+  #conveyorStart = () => {
+    this.#metrics = new RunMetrics(performance.now())
+    this.#files = new Map()
+    this.#run = {files: []}
+
+    const start = {type: "start", time: new Date().toISOString()}
+
+    if(this.#shard)
+      start.shard = this.#shard
+
+    this.#emit(start)
+  }
+
+  #conveyorQueue = ({file, output, outputs}) => {
+    this.#metrics.queued(file, performance.now())
+    this.#files.set(file,
+      {outputs: outputs ?? [output], status: null, cache: null, warning: null, error: null, reported: false})
+  }
+
+  #updateData = ({file, message}) => {
+    const item = this.#files.get(file)
+
+    if(!item)
+      return
+
+    switch(message.kind) {
+      case "stage":
+        this.#metrics.stage(file, message.stage, message.state, message.at ?? performance.now())
+
+        if(message.state === "warning")
+          item.warning = message.detail ?? null
+
+        if(message.state === "error") {
+          item.status = "error"
+          item.error = message.detail ?? null
+          this.#complete(file, item)
+        }
+
+        break
+
+      case "input-size":
+        this.#metrics.size(file, message.kind, message.value)
+        break
+
+      case "output-size":
+        this.#metrics.size(file, message.kind, message.value)
+        item.status = item.warning !== null || message.value === 0 ? "warning" : "success"
+        this.#complete(file, item)
+        break
+
+      case "cache":
+        item.cache = message.value
+        break
+    }
+  }
+
+  /**
+   * Record a finished file, once.
+   *
+   * @param {FileObject} file - The file
+   * @param {object} item - Its tracked status
+   */
+  #complete(file, item) {
+    if(item.reported)
+      return
+
+    item.reported = true
+
+    const record = {
+      type: "file",
+      ...this.#metrics.file(file),
+      input: FS.toRelativePath(this.#basePath.path, file.path),
+      outputs: item.outputs.map(output => FS.toRelativePath(this.#basePath.path, output.path)),
+      status: item.status,
+      cache: item.cache,
+    }
+
+    if(item.warning !== null)
+      record.warning = item.warning
+
+    if(item.error !== null)
+      record.error = item.error
+
+    this.#emit(record)
+  }
+
+  /**
+   * Finish the current run's report and flush it.
+   *
+   * @param {object} result - The processFiles result
+   * @returns {Promise<void>}
+   */
+  async end(result) {
+    // Failures thrown out of the pipeline carry no stage event; pick them up
+    // from the result.
+    for(const {input, error} of result.errored) {
+      let item = this.#files.get(input)
+
+      // Nor do files that never entered it (e.g. no route matched).
+      if(!item) {
+        item = {outputs: [], status: null, cache: null, warning: null, error: null, reported: false}
+        this.#files.set(input, item)
+      }
+
+      if(!item.reported) {
+        item.status = "error"
+        item.error = error?.message ?? String(error)
+        this.#complete(input, item)
+      }
+    }
+
+    const {stages, queueWait, bytesIn, bytesOut} = this.#metrics.summary()
+
+    this.#emit({
+      type: "end",
+      time: new Date().toISOString(),
+      durationMs: Number(result.duration),
+      totalFiles: result.totalFiles,
+      succeeded: result.succeeded.length,
+      warned: result.warned.length,
+      errored: result.errored.length,
+      cache: result.cache ?? null,
+      stages,
+      queueWait,
+      bytesIn,
+      bytesOut,
+    })
+
+    if(this.#format === "json") {
+      const {start, files, end} = this.#run
+
+      this.#write(`${JSON.stringify({start, files, end})}\n`)
+    }
+
+    this.#write(null)
+
+    await this.#pending
+
+    if(this.#error) {
+      const error = this.#error
+
+      this.#error = null
+
+      throw Sass.new(`Writing run report ${this.#destination}`, error)
+    }
+  }
+
+  /**
+   * Queue a record: written straight away as NDJSON, or kept for the JSON
+   * object written at the end.
+   *
+   * @param {object} record - The record
+   */
+  #emit(record) {
+    if(this.#format === "ndjson") {
+      this.#write(`${JSON.stringify(record)}\n`)
+
+      return
+    }
+
+    const {type, ...rest} = record
+
+    if(type === "file")
+      this.#run.files.push(rest)
+    else
+      this.#run[type] = rest
+  }
+
+  /**
+   * Chain a write to the destination; `null` closes an open report file.
+   * The chain never rejects: the first failure (e.g. a report directory
+   * that does not exist) is held for end() to throw, and the run's later
+   * records are dropped, rather than the rejection going unhandled mid-run.
+   *
+   * @param {string|null} text - What to write
+   */
+  #write(text) {
+    this.#pending = this.#pending.then(async() => {
+      if(this.#error && text !== null)
+        return
+
+      if(this.#destination === "-") {
+        if(text !== null)
+          await new Promise((resolve, reject) =>
+            process.stdout.write(text, error => error ? reject(error) : resolve()))
+
+        return
+      }
+
+      if(text === null) {
+        await this.#handle?.close()
+        this.#handle = null
+
+        return
+      }
+
+      if(!this.#handle) {
+        const flags = this.#written && this.#format === "ndjson" ? "a" : "w"
+
+        this.#handle = await fs.open(this.#destination, flags)
+        this.#written = true
+      }
+
+      await this.#handle.write(text)
+    }).catch(error => {
+      this.#error ??= error
+    })
+  }
+}
@@ -0,0 +1,232 @@
+import {Sass} from "@gesslar/toolkit"
+import fs from "node:fs/promises"
+import process from "node:process"
+
+import RunMetrics from "./RunMetrics.js"
+import RunReport from "./RunReport.js"
+
+/**
+ * Combines what the shards of a sharded build (see InputSource) each wrote
+ * into one run report and one output manifest, as though a single machine
+ * had done the whole build.
+ *
+ * Run reports may be JSON or NDJSON (the last run in the file is taken);
+ * manifests are the JSON written by OutputManifest. The merged report's
+ * `end` record sums the shards' counts, cache statistics and bytes, takes
+ * the longest shard's duration (shards run side by side), and recomputes
+ * the latency summaries from the merged `file` records. In the merged
+ * manifest, an output is orphaned only if no shard wrote or kept it.
+ *
+ * Every input must come from a different shard of the same count; shards
+ * that are missing are listed as `missingShards`, rather than failing the
+ * merge, so that a partial build can still be inspected.
+ */
+export default class ShardMerge {
+  /**
+   * Read run reports and manifests, telling them apart by their content.
+   *
+   * @param {Array<string>} paths - The files
+   * @returns {Promise<{reports: Array<object>, manifests: Array<object>}>}
+   *   Each report as `{start, files, end}`, and each manifest
+   */
+  static async load(paths) {
+    const reports = []
+    const manifests = []
+
+    for(const path of paths) {
+      const text = await fs.readFile(path, "utf8")
+      let data
+
+      try {
+        data = JSON.parse(text)
+      } catch {
+        // Not a single JSON document: an NDJSON report.
+        reports.push(ShardMerge.#lastRun(text, path))
+        continue
+      }
+
+      if(Array.isArray(data?.created))
+        manifests.push(data)
+      else if(data?.start && data?.end)
+        reports.push(data)
+      else
+        throw Sass.new(`${path} is neither a run report nor an output manifest`)
+    }
+
+    return {reports, manifests}
+  }
+
+  /**
+   * Merge the shards' run reports.
+   *
+   * @param {Array<{start: object, files: Array<object>, end: object}>} reports
+   *   Each shard's report
+   * @returns {{start: object, files: Array<object>, end: object}} The report
+   */
+  static reports(reports) {
+    const shards = ShardMerge.#shards(reports.map(report => report.start.shard))
+    const files = reports.flatMap(report => report.files)
+      .toSorted((a, b) => a.input < b.input ? -1 : a.input > b.input ? 1 : 0)
+    const ends = reports.map(report => report.end)
+    const sum = key => ends.reduce((total, end) => total + (end[key] ?? 0), 0)
+    const perStage = {}
+
+    for(const file of files) {
+      for(const [stage, duration] of Object.entries(file.stages ?? {})) {
+        perStage[stage] ??= []
+        perStage[stage].push(duration)
+      }
+    }
+
+    const caches = ends.map(end => end.cache).filter(Boolean)
+
+    return {
+      start: {
+        time: reports.map(report => report.start.time).toSorted()[0],
+        ...shards,
+      },
+      files,
+      end: {
+        time: ends.map(end => end.time).toSorted().at(-1),
+        durationMs: Math.max(...ends.map(end => end.durationMs)),
+        totalFiles: sum("totalFiles"),
+        succeeded: sum("succeeded"),
+        warned: sum("warned"),
+        errored: sum("errored"),
+        cache: caches.length === 0
+          ? null
+          : caches.reduce((total, cache) => {
+            for(const [key, count] of Object.entries(cache))
+              total[key] = (total[key] ?? 0) + count
+
+            return total
+          }, {}),
+        stages: Object.fromEntries(Object.entries(perStage)
+          .map(([stage, samples]) => [stage, RunMetrics.histogram(samples)])),
+        queueWait: RunMetrics.histogram(files
+          .map(file => file.queueWaitMs)
+          .filter(wait => wait != null)),
+        bytesIn: sum("bytesIn"),
+        bytesOut: sum("bytesOut"),
+      },
+    }
+  }
+
+  /**
+   * Merge the shards' output manifests.
+   *
+   * @param {Array<object>} manifests - Each shard's manifest
+   * @returns {object} The manifest
+   */
+  static manifests(manifests) {
+    const shards = ShardMerge.#shards(manifests.map(manifest => manifest.shard))
+    const union = status => [...new Set(manifests.flatMap(manifest => manifest[status] ?? []))].toSorted()
+    const merged = {
+      created: union("created"),
+      updated: union("updated"),
+      unchanged: union("unchanged"),
+    }
+    const owned = new Set([...merged.created, ...merged.updated, ...merged.unchanged])
+
+    merged.orphaned = union("orphaned").filter(output => !owned.has(output))
+
+    return {...merged, ...shards}
+  }
+
+  /**
+   * Write a merged report in the format its destination implies (see
+   * RunReport.formatFor), or as NDJSON on stdout for `-`.
+   *
+   * @param {{start: object, files: Array<object>, end: object}} report - The
+   *   merged report
+   * @param {string} destination - The file, or `-`
+   * @returns {Promise<void>}
+   */
+  static async writeReport(report, destination) {
+    const {start, files, end} = report
+    const text = RunReport.formatFor(destination) === "json"
+      ? `${JSON.stringify({start, files, end})}\n`
+      : [
+        {type: "start", ...start},
+        ...files.map(file => ({type: "file", ...file})),
+        {type: "end", ...end},
+      ].map(record => `${JSON.stringify(record)}\n`).join("")
+
+    if(destination === "-")
+      process.stdout.write(text)
+    else
+      await fs.writeFile(destination, text)
+  }
+
+  /**
+   * Write a merged manifest as JSON.
+   *
+   * @param {object} manifest - The merged manifest
+   * @param {string} destination - The file
+   * @returns {Promise<void>}
+   */
+  static async writeManifest(manifest, destination) {
+    await fs.writeFile(destination, `${JSON.stringify(manifest, null, 2)}\n`)
+  }
+
+  /**
+   * The last run in an NDJSON report.
+   *
+   * @param {string} text - The report
+   * @param {string} path - Its path, for errors
+   * @returns {{start: object, files: Array<object>, end: object}} The run
+   */
+  static #lastRun(text, path) {
+    let run = null
+
+    for(const line of text.split("\n")) {
+      if(line.trim() === "")
+        continue
+
+      const {type, ...record} = JSON.parse(line)
+
+      if(type === "start")
+        run = {start: record, files: [], end: null}
+      else if(type === "file")
+        run?.files.push(record)
+      else if(type === "end" && run)
+        run.end = record
+    }
+
+    if(!run?.end)
+      throw Sass.new(`${path} has no complete run`)
+
+    return run
+  }
+
+  /**
+   * Check a set of shards belongs together and note any that are missing.
+   *
+   * @param {Array<{index: number, count: number}|undefined>} shards - Each
+   *   input's shard
+   * @returns {{shards: number, missingShards?: Array<number>}} The shard count
+   *   and missing shard indices
+   */
+  static #shards(shards) {
+    if(shards.some(shard => !shard))
+      throw Sass.new("Every run report and manifest to merge must come from a sharded run")
+
+    const [{count}] = shards
+
+    if(shards.some(shard => shard.count !== count))
+      throw Sass.new(`Shards of different counts cannot be merged (${[...new Set(shards.map(shard => shard.count))].join(", ")})`)
+
+    const indices = shards.map(shard => shard.index)
+    const repeated = indices.filter((index, at) => indices.indexOf(index) !== at)
+
+    if(repeated.length > 0)
+      throw Sass.new(`Shard ${repeated[0]}/${count} is given more than once`)
+
+    const missing = Array.from({length: count}, (_, at) => at + 1)
+      .filter(index => !indices.includes(index))
+
+    return missing.length > 0
+      ? {shards: count, missingShards: missing}
+      : {shards: count}
+  }
+}
@@ -0,0 +1,123 @@
+import fs from "node:fs"
+import readline from "node:readline"
+import {Readable} from "node:stream"
+
+/**
+ * Access to source files in the form a parser asks for.
+ *
+ * Files are read as raw bytes, and their size is the byte count the read
+ * produced; nothing is decoded until the parser needs text. A parser's
+ * `meta` chooses its input:
+ *
+ * - by default, the file's text, decoded once, straight from the bytes, in
+ *   the configured `encoding` (any WHATWG encoding label, e.g. `latin1` or
+ *   `windows-1252` for older LPC mudlibs);
+ * - `buffer: true`, the raw Buffer, undecoded, for parsers that scan bytes
+ *   themselves;
+ * - `stream: true`, an async iterator of lines (without line terminators),
+ *   decoded as they are read, so peak memory is bounded by what the parser
+ *   itself chooses to hold on to, not by the file size.
+ *
+ * Text is always decoded by a WHATWG TextDecoder, whole or line by line,
+ * so a file reads the same whichever way its parser takes it. Other than
+ * UTF-8 it is decoded in streaming mode even when whole: Node's one-shot
+ * decode of `latin1`/`windows-1252` (like its Buffer `latin1`) is
+ * ISO-8859-1, where the WHATWG encoding is windows-1252.
+ */
+export default class SourceReader {
+  /**
+   * Whether a parser declares the streaming input protocol.
+   *
+   * @param {object} parser - The parser action class
+   * @returns {boolean} True if the parser wants a line iterator
+   */
+  static wantsStream(parser) {
+    return parser?.meta?.stream === true
+  }
+
+  /**
+   * Whether a parser declares that it takes the raw Buffer.
+   *
+   * @param {object} parser - The parser action class
+   * @returns {boolean} True if the parser wants the undecoded bytes
+   */
+  static wantsBuffer(parser) {
+    return parser?.meta?.buffer === true
+  }
+
+  /**
+   * Whether an encoding label is one this runtime can decode.
+   *
+   * @param {string} encoding - The encoding label
+   * @returns {boolean} True if it is supported
+   */
+  static supports(encoding) {
+    try {
+      new TextDecoder(encoding)
+
+      return true
+    } catch {
+      return false
+    }
+  }
+
+  /**
+   * The input a (non-streaming) parser receives for a file's bytes.
+   *
+   * @param {object} parser - The parser action class
+   * @param {Uint8Array} bytes - The file's bytes (a Buffer, or as received
+   *   from another thread)
+   * @param {string} [encoding] - The file's character encoding
+   * @returns {Buffer|string} The Buffer, or the decoded text
+   */
+  static input(parser, bytes, encoding = "utf8") {
+    if(SourceReader.wantsBuffer(parser))
+      return Buffer.isBuffer(bytes)
+        ? bytes
+        : Buffer.from(bytes.buffer, bytes.byteOffset, bytes.byteLength)
+
+    const decoder = new TextDecoder(encoding)
+
+    // UTF-8 decodes the same either way, and fastest in one go.
+    if(decoder.encoding === "utf-8")
+      return decoder.decode(bytes)
+
+    return decoder.decode(bytes, {stream: true}) + decoder.decode()
+  }
+
+  /**
+   * Iterate a file line by line. Handles `\n` and `\r\n` endings. The file
+   * is closed when the iteration ends, including when the parser stops
+   * early.
+   *
+   * @param {string} path - The file to read
+   * @param {object} [options]
+   * @param {string} [options.encoding] - The file's character encoding
+   * @yields {string} The file's lines
+   */
+  static async *lines(path, {encoding = "utf8"} = {}) {
+    const file = fs.createReadStream(path)
+    const input = Readable.from(SourceReader.#decode(file, encoding))
+    const reader = readline.createInterface({input, crlfDelay: Infinity})
+
+    try {
+      yield* reader
+    } finally {
+      reader.close()
+      input.destroy()
+      file.destroy()
+    }
+  }
+
+  static async *#decode(chunks, encoding) {
+    const decoder = new TextDecoder(encoding)
+
+    for await(const chunk of chunks)
+      yield decoder.decode(chunk, {stream: true})
+
+    const rest = decoder.decode()
+
+    if(rest)
+      yield rest
+  }
+}
@@ -0,0 +1,95 @@
+/**
+ * A counting semaphore for one group of {@link Conveyor} stages.
+ *
+ * At most `limit` files run the pool's work at once; the rest wait in the
+ * pool's queue, in arrival order. A file holds a slot only while it is
+ * actually in the pool's stages, so a file stuck writing to a slow disk, or
+ * in a slow network hook, does not keep a parsing slot from somebody else.
+ *
+ * The queues need no bound of their own: Conveyor admits only so many files
+ * at a time and each waits in at most one queue, so together they never
+ * hold more than the admitted files.
+ */
+export default class StagePool {
+  #name
+  #limit
+  #active = 0
+
+  /** Resolvers of the files waiting for a slot. @type {Array<Function>} */
+  #waiting = []
+
+  #peakActive = 0
+  #peakWaiting = 0
+
+  /**
+   * Constructor for StagePool.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {string} arg.name - The pool's name, for reporting
+   * @param {number} arg.limit - How many may run at once
+   */
+  constructor({name, limit}) {
+    this.#name = name
+    this.#limit = Math.max(1, limit)
+  }
+
+  get name() {
+    return this.#name
+  }
+
+  /**
+   * Run work in a slot, waiting for one first if the pool is full.
+   *
+   * @template T
+   * @param {() => Promise<T>|T} work - The work
+   * @returns {Promise<T>} What the work returned
+   */
+  async run(work) {
+    await this.#acquire()
+
+    try {
+      return await work()
+    } finally {
+      this.#release()
+    }
+  }
+
+  async #acquire() {
+    if(this.#active < this.#limit) {
+      this.#active++
+      this.#peakActive = Math.max(this.#peakActive, this.#active)
+
+      return
+    }
+
+    // The releasing file hands its slot straight over, so #active is
+    // already counting us when this resolves.
+    await new Promise(resolve => {
+      this.#waiting.push(resolve)
+      this.#peakWaiting = Math.max(this.#peakWaiting, this.#waiting.length)
+    })
+  }
+
+  #release() {
+    const next = this.#waiting.shift()
+
+    if(next)
+      next()
+    else
+      this.#active--
+  }
+
+  /**
+   * Summarise the pool's use over the run.
+   *
+   * @returns {{limit: number, peakActive: number, peakWaiting: number}} The
+   *   limit and the most files running and waiting at once
+   */
+  summary() {
+    return {
+      limit: this.#limit,
+      peakActive: this.#peakActive,
+      peakWaiting: this.#peakWaiting,
+    }
+  }
+}
@@ -0,0 +1,179 @@
+import {FileObject} from "@gesslar/toolkit"
+import fs from "node:fs"
+import path from "node:path"
+
+/**
+ * @import {DirectoryObject, Glog} from "@gesslar/toolkit"
+ * @import BeDoc from "./BeDoc.js"
+ * @import InputSource from "./InputSource.js"
+ */
+
+/**
+ * Watches the project for changes to files matching the configured `input`
+ * patterns (and not `exclude`d) and regenerates their documentation through a single, already
+ * negotiated {@link BeDoc} instance.
+ *
+ * Change events are debounced and batched so that a burst of saves (or a
+ * branch checkout) becomes one Conveyor run. Files that disappeared have
+ * their outputs removed instead. A batch that arrives while a run is still
+ * in progress is held until that run finishes.
+ *
+ * The watch covers the whole base path, so events from the directories
+ * BeDoc itself writes to (output, targets, caches) are dropped before
+ * anything else looks at them; regenerated documentation never queues
+ * another run.
+ */
+export default class Watcher {
+  /** @type {BeDoc} */
+  #bedoc
+
+  /** @type {DirectoryObject} */
+  #basePath
+
+  /** @type {InputSource} */
+  #input
+
+  /** @type {Array<string>} */
+  #ignored
+
+  #delay
+
+  /** @type {Glog} */
+  #glog
+
+  #onRun
+
+  /** @type {Set<string>} */
+  #pending = new Set()
+
+  #timer = null
+  #running = null
+
+  /** @type {fs.FSWatcher|null} */
+  #watcher = null
+
+  /**
+   * Constructor for Watcher.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {BeDoc} arg.bedoc - The negotiated BeDoc instance to reuse
+   * @param {DirectoryObject} arg.basePath - The project root to watch
+   * @param {InputSource} arg.input - The configured input set
+   * @param {Array<DirectoryObject|string>} [arg.ignore] - Directories under the
+   *   base path whose changes are not BeDoc's input (its own outputs)
+   * @param {number} [arg.delay] - Debounce window in milliseconds
+   * @param {Glog} arg.glog - Glog instance
+   * @param {Function} [arg.onRun] - Called with `{changed, removed, result}`
+   *   after every batch
+   */
+  constructor({bedoc, basePath, input, ignore = [], delay = 100, glog, onRun}) {
+    this.#bedoc = bedoc
+    this.#basePath = basePath
+    this.#input = input
+    this.#ignored = ignore.map(dir => path.resolve(basePath.path, dir.path ?? dir))
+    this.#delay = delay
+    this.#glog = glog
+    this.#onRun = onRun
+  }
+
+  /**
+   * Begin watching.
+   *
+   * @returns {Watcher} This object for chaining.
+   */
+  start() {
+    this.#watcher = fs.watch(
+      this.#basePath.path,
+      {recursive: true},
+      (_event, filename) => this.#queue(filename)
+    )
+
+    this.#glog.debug("Watching %o", 1, this.#basePath.path)
+
+    return this
+  }
+
+  /**
+   * Stop watching. A run already in progress is allowed to finish.
+   *
+   * @returns {Promise<void>}
+   */
+  async close() {
+    clearTimeout(this.#timer)
+    this.#watcher?.close()
+    this.#watcher = null
+
+    await this.#running
+  }
+
+  /**
+   * Whether a path, relative to the base path, is an input.
+   *
+   * @param {string} relative - The relative path
+   * @returns {boolean} True if the path is an input
+   */
+  matches(relative) {
+    return this.#input.matches(relative)
+  }
+
+  #queue(filename) {
+    if(!filename)
+      return
+
+    const relative = filename.toString()
+    const absolute = path.resolve(this.#basePath.path, relative)
+
+    if(this.#isIgnored(absolute) || !this.matches(relative))
+      return
+
+    this.#pending.add(absolute)
+
+    clearTimeout(this.#timer)
+    this.#timer = setTimeout(this.#flush, this.#delay)
+  }
+
+  #isIgnored(absolute) {
+    return this.#ignored.some(dir =>
+      absolute === dir || absolute.startsWith(`${dir}${path.sep}`))
+  }
+
+  #flush = async() => {
+    if(this.#running || this.#pending.size === 0)
+      return
+
+    const batch = [...this.#pending]
+
+    this.#pending.clear()
+
+    this.#running = this.#process(batch)
+      .catch(error => this.#glog.error(error))
+      .finally(() => {
+        this.#running = null
+
+        // Saves that landed mid-run were held back; pick them up now.
+        if(this.#pending.size > 0)
+          this.#flush()
+      })
+  }
+
+  async #process(batch) {
+    const changed = []
+    const removed = []
+
+    for(const file of batch.map(p => new FileObject(p)))
+      (await file.exists ? changed : removed).push(file)
+
+    this.#glog.debug("Batch: %o changed, %o removed", 1,
+      changed.length, removed.length)
+
+    const dropped = removed.length > 0
+      ? await this.#bedoc.removeOutputs(removed)
+      : []
+
+    const result = changed.length > 0
+      ? await this.#bedoc.processFiles(changed)
+      : null
+
+    this.#onRun?.({changed, removed: dropped, result})
+  }
+}
@@ -0,0 +1,196 @@
+import {Sass} from "@gesslar/toolkit"
+import {Worker} from "node:worker_threads"
+
+/**
+ * A fixed-size pool of `worker_threads` that executes Conveyor tasks off the
+ * main event loop.
+ *
+ * Tasks are queued and handed to the next idle worker. Each worker reports
+ * back with `stage` messages (forwarded to the task's `onStage` callback so
+ * the main thread can re-emit them) and exactly one terminal `result` or
+ * `error` message.
+ */
+export default class WorkerPool {
+  /** @type {Array<Worker>} */
+  #workers = []
+
+  /** @type {Array<Worker>} */
+  #idle = []
+
+  /** Tasks waiting for an idle worker. */
+  #queue = []
+
+  /** In-flight tasks keyed by id. @type {Map<number, object>} */
+  #tasks = new Map()
+
+  /** Workers that finished loading their modules. @type {WeakSet<Worker>} */
+  #ready = new WeakSet()
+
+  #nextId = 0
+  #script
+  #workerData
+  #closed = false
+
+  /**
+   * Constructor for WorkerPool.
+   *
+   * @param {object} arg - Constructor argument
+   * @param {number} arg.size - Number of workers to spawn
+   * @param {URL|string} arg.script - The worker entry module
+   * @param {object} [arg.workerData] - Data handed to every worker on start
+   */
+  constructor({size, script, workerData}) {
+    this.#script = script
+    this.#workerData = workerData
+
+    for(let i = 0; i < Math.max(1, size); i++)
+      this.#spawn()
+  }
+
+  get size() {
+    return this.#workers.length
+  }
+
+  /**
+   * Queues a task for execution in a worker.
+   *
+   * @param {string} task - The task name understood by the worker
+   * @param {unknown} payload - Structured-cloneable task input
+   * @param {Function} [onStage] - Receives `{stage, state}` updates
+   * @param {Array<ArrayBuffer>} [transfer] - Parts of the payload to move to
+   *   the worker instead of copying; they are unusable here afterwards
+   * @returns {Promise<unknown>} Resolves with the worker's result
+   */
+  run(task, payload, onStage, transfer = []) {
+    if(this.#closed)
+      return Promise.reject(Sass.new("Worker pool is closed"))
+
+    return new Promise((resolve, reject) => {
+      this.#queue.push({
+        id: this.#nextId++, task, payload, onStage, transfer, resolve, reject
+      })
+
+      this.#dispatch()
+    })
+  }
+
+  /**
+   * Terminates every worker. Tasks still queued are rejected.
+   *
+   * @returns {Promise<void>}
+   */
+  async close() {
+    this.#closed = true
+
+    for(const job of this.#queue.splice(0))
+      job.reject(Sass.new("Worker pool closed before task ran"))
+
+    await Promise.all(this.#workers.map(w => w.terminate()))
+
+    this.#workers = []
+    this.#idle = []
+  }
+
+  #spawn() {
+    const worker = new Worker(this.#script, {workerData: this.#workerData})
+
+    worker.on("message", message => this.#receive(worker, message))
+    worker.on("error", error => this.#crash(worker, error))
+    worker.on("exit", code => {
+      if(code !== 0)
+        this.#crash(worker, Sass.new(`Worker exited with code ${code}`))
+    })
+
+    this.#workers.push(worker)
+    this.#idle.push(worker)
+
+    return worker
+  }
+
+  #dispatch() {
+    while(this.#idle.length && this.#queue.length) {
+      const worker = this.#idle.shift()
+      const job = this.#queue.shift()
+
+      job.worker = worker
+      this.#tasks.set(job.id, job)
+
+      worker.postMessage({id: job.id, task: job.task, payload: job.payload}, job.transfer)
+    }
+  }
+
+  #receive(worker, {id, type, ...message}) {
+    if(type === "ready") {
+      this.#ready.add(worker)
+
+      return
+    }
+
+    const job = this.#tasks.get(id)
+
+    if(!job)
+      return
+
+    switch(type) {
+      case "stage":
+        job.onStage?.(message)
+
+        return
+
+      case "result":
+        job.resolve(message.value)
+        break
+
+      case "error": {
+        const error = new Error(message.error.message)
+
+        error.stack = message.error.stack
+        job.reject(error)
+        break
+      }
+    }
+
+    this.#tasks.delete(id)
+    this.#idle.push(worker)
+    this.#dispatch()
+  }
+
+  /**
+   * A worker died. Fail whatever it was running and, unless the pool is
+   * shutting down, replace it so queued work can still drain.
+   *
+   * @param {Worker} worker - The worker that failed
+   * @param {Error} error - The failure
+   */
+  #crash(worker, error) {
+    if(!this.#workers.includes(worker))
+      return
+
+    for(const [id, job] of this.#tasks) {
+      if(job.worker !== worker)
+        continue
+
+      this.#tasks.delete(id)
+      job.reject(Sass.new("Worker failed", error))
+    }
+
+    this.#workers = this.#workers.filter(w => w !== worker)
+    this.#idle = this.#idle.filter(w => w !== worker)
+
+    if(this.#closed)
+      return
+
+    // A worker that could not even load its modules will fail again, so
+    // don't respawn it. Once nobody is left, nothing queued can ever run.
+    if(!this.#ready.has(worker)) {
+      if(this.#workers.length === 0)
+        for(const job of this.#queue.splice(0))
+          job.reject(Sass.new("Worker failed", error))
+
+      return
+    }
+
+    this.#spawn()
+    this.#dispatch()
+  }
+}
@@ -1,16 +1,27 @@
 #!/usr/bin/env node
 
-import {Schemer} from "@gesslar/negotiator"
-import {Data, DirectoryObject, FileObject, Glog, Sass, Tantrum, Term} from "@gesslar/toolkit"
-import {program} from "commander"
+import module from "node:module"
 import process from "node:process"
 import url from "node:url"
 
-import BeDoc from "./BeDoc.js"
-import {ConfigurationParameters} from "./ConfigurationParameters.js"
-import Environment from "./Environment.js"
-import Schema from "./Schema.js"
-import CLIOutput from "./CLIOutput.js"
+// Keep V8's compiled code for BeDoc and its dependencies on disk (in
+// NODE_COMPILE_CACHE, or the temp directory), so later invocations skip
+// parsing and compiling it; see bench/startup.js. Only modules loaded after
+// this are cached, so everything else is imported dynamically: what every
+// invocation needs here, and the rest only where, and if, it is needed.
+module.enableCompileCache()
+
+const [
+  {Data, DirectoryObject, FileObject, Glog, Sass, Tantrum, Term},
+  {program},
+  {ConfigurationParameters},
+  {default: Environment},
+] = await Promise.all([
+  import("@gesslar/toolkit"),
+  import("commander"),
+  import("./ConfigurationParameters.js"),
+  import("./Environment.js"),
+])
 
 // Main entry point
 void (async() => {
@@ -56,6 +67,10 @@ void (async() => {
     program.helpOption("-h, --help", "Output usage information")
     program.parse()
 
+    // Parsing exits for --help and --version, so the engine is only loaded
+    // for an actual run.
+    const {default: BeDoc} = await import("./BeDoc.js")
+
     // Get options
     const options = program.opts()
 
@@ -88,7 +103,12 @@ void (async() => {
       source: Environment.CLI,
     })
 
-    const cliOutput = new CLIOutput({config})
+    // Progress is only drawn for a person watching a terminal. Piped or CI
+    // runs, and runs streaming their report to stdout, skip all drawing.
+    const interactive = Boolean(process.stdout.isTTY) && config.report !== "-"
+    const cliOutput = interactive
+      ? new (await import("./CLIOutput.js")).default({config})
+      : null
 
     const validateBeDocSchema = await loadSchemaValidator(thisPath)
 
@@ -107,25 +127,50 @@ void (async() => {
       }
     }
 
-    Term.altScreen()
+    interactive && Term.altScreen()
 
     const result = await bedoc.processFiles()
 
-    Term.mainScreen()
+    interactive && Term.mainScreen()
+
+    cliOutput?.render(false)
+    reportResult(result, glog, config)
+
+    if(config.watch) {
+      const {default: Watcher} = await import("./Watcher.js")
+      const watcher = new Watcher({
+        bedoc,
+        basePath: config.basePath,
+        input: config.input,
+        ignore: [
+          config.output,
+          ...(config.targets ?? []).map(target => target.output),
+          config.cacheDir,
+        ].filter(Boolean),
+        delay: config.watchDelay,
+        glog,
+        onRun: ({removed, result}) => {
+          removed.forEach(f => Term.info(`Removed ${f.path}`))
 
-    cliOutput.render(false)
+          if(result) {
+            cliOutput?.render(false)
+            reportResult(result, glog, config)
+          }
+        },
+      }).start()
 
-    const errored = result.errored
-    const warned = result.warned
+      Term.info("Watching for changes (Ctrl+C to stop)")
 
-    if(warned?.length > 0)
-      warned.forEach(w => glog.warn(w.warning))
+      process.once("SIGINT", async() => {
+        await watcher.close()
+        bedoc.close()
+        process.exit(0)
+      })
 
-    if(errored?.length > 0) {
-      const errors = errored.map(e => e.error)
-      Tantrum.new("Error processing files", errors).report(true)
+      return
     }
 
+    bedoc.close()
     process.exit(0)
   } catch(error) {
     Term.mainScreen()
@@ -141,10 +186,42 @@ void (async() => {
    * @returns {Promise<Function>} AJV validator function
    */
   async function loadSchemaValidator(pkgPath) {
+    const [{Schemer}, {default: Schema}] = await Promise.all([
+      import("@gesslar/negotiator"),
+      import("./Schema.js"),
+    ])
     const schemaFile = new FileObject(Schema.local, pkgPath)
     if(!(await schemaFile.exists))
       throw Sass.new(`Missing schema at ${schemaFile.path}`)
 
     return await Schemer.fromFile(schemaFile)
   }
+
+  /**
+   * Report the warnings and errors of a completed run. Without the progress
+   * display, a one-line summary stands in for it (unless stdout carries the
+   * run report).
+   *
+   * @param {object} result - The result of BeDoc#processFiles
+   * @param {Glog} glog - The logger to warn through
+   * @param {object} config - The resolved configuration
+   */
+  function reportResult(result, glog, config) {
+    const errored = result.errored
+    const warned = result.warned
+
+    if(!process.stdout.isTTY && config.report !== "-")
+      Term.info(
+        `Processed ${result.totalFiles} files in ${result.duration}ms: ` +
+        `${result.succeeded.length} succeeded, ${warned.length} warned, ${errored.length} errored`
+      )
+
+    if(warned?.length > 0)
+      warned.forEach(w => glog.warn(w.warning))
+
+    if(errored?.length > 0) {
+      const errors = errored.map(e => e.error)
+      Tantrum.new("Error processing files", errors).report(true)
+    }
+  }
 })()
@@ -0,0 +1,54 @@
+#!/usr/bin/env node
+
+import {Glog, Sass} from "@gesslar/toolkit"
+import {program} from "commander"
+import process from "node:process"
+
+import ShardMerge from "./ShardMerge.js"
+
+// Entry point for `bedoc-merge`: combines the run reports and manifests of a
+// sharded build (see BeDoc's `shard` option) into one of each.
+void (async() => {
+  const glog = new Glog()
+
+  try {
+    program
+      .name("bedoc-merge")
+      .description("Merge the run reports and output manifests of a sharded BeDoc build")
+      .argument("<files...>", "Run reports (JSON or NDJSON) and manifests from each shard")
+      .option("-R, --report <file>", "Write the merged run report here (JSON if it ends in .json, - for stdout)", "-")
+      .option("-M, --manifest <file>", "Write the merged output manifest here")
+      .helpOption("-h, --help", "Output usage information")
+      .parse()
+
+    const {report, manifest} = program.opts()
+    const {reports, manifests} = await ShardMerge.load(program.args)
+
+    if(reports.length > 0) {
+      const merged = ShardMerge.reports(reports)
+
+      await ShardMerge.writeReport(merged, report)
+
+      if(merged.start.missingShards)
+        glog.warn(`Shards missing from the run reports: ${merged.start.missingShards.join(", ")}`)
+    }
+
+    if(manifests.length > 0) {
+      if(!manifest)
+        throw Sass.new("Manifests were given but no --manifest to write the merged one to")
+
+      const merged = ShardMerge.manifests(manifests)
+
+      await ShardMerge.writeManifest(merged, manifest)
+
+      if(merged.missingShards)
+        glog.warn(`Shards missing from the manifests: ${merged.missingShards.join(", ")}`)
+    }
+
+    process.exit(0)
+  } catch(error) {
+    Sass.new("Merging shards", error).report(true)
+
+    process.exit(1)
+  }
+})()